@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+/// @brief The time source used for every timed step. On the Pico this is the hardware timer, on the host it is a
+/// virtual clock that advances instantly.
+class AbstractClock
+{
+public:
+    virtual ~AbstractClock() = default;
+
+    virtual void sleepFor(std::chrono::milliseconds delay) = 0;
+
+    /// @brief Sleeps until the clock reaches the given time, returning straight away if it has already passed.
+    virtual void sleepUntil(std::chrono::microseconds time) = 0;
+
+    /// @brief Puts the core to sleep until notifyEvent() is called or the deadline passes. An event notified before the
+    /// wait starts isn't lost, but waits can also end early, so callers should check what they are waiting for again.
+    /// @return True if the deadline was reached.
+    virtual bool waitForEvent(std::chrono::microseconds deadline = std::chrono::microseconds::max()) = 0;
+
+    /// @brief Wakes anything waiting in waitForEvent(). Safe to call from interrupts and from the other core.
+    virtual void notifyEvent() = 0;
+
+    virtual std::chrono::microseconds now() const = 0;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief A region of NOR flash set aside for storage. Erasing a sector sets every byte to 0xff, and programming can only
+/// clear bits, so a page must be erased before it can be written with anything else. Offsets are from the start of the
+/// region.
+class AbstractFlash
+{
+public:
+    virtual ~AbstractFlash() = default;
+
+    virtual size_t getSectorSize() const = 0;
+    virtual size_t getPageSize() const = 0;
+    virtual size_t getSectorCount() const = 0;
+
+    virtual void read(size_t offset, void *data, size_t length) const = 0;
+
+    virtual void erase(size_t sector) = 0;
+
+    /// @brief Programs whole pages. Both offset and length must be multiples of the page size.
+    virtual void program(size_t offset, const void *data, size_t length) = 0;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+#include "hardware_types.h"
+
+/// @brief The output backend used to drive and read pins. On the Pico this talks to the SIO block, on the host it is
+/// simulated.
+class AbstractGpio
+{
+public:
+    /// @brief Called from interrupt context with the level of the pin after the edge and the time it was seen, so it must
+    /// be short and must not block.
+    typedef void (*EdgeCallback)(uint pin, bool level, std::chrono::microseconds timestamp, void *context);
+
+    virtual ~AbstractGpio() = default;
+
+    /// @brief Makes a pin an output. A pin that is already an output is left showing what it was, so lights driven
+    /// straight after reset don't go out again while the traffic lights are being set up.
+    virtual void initOutputPin(uint pin) = 0;
+
+    /// @brief Makes every pin in mask an output showing the matching bit in values, with a single value write followed
+    /// by a single direction write so no pin floats or shows the wrong value in between.
+    virtual void initOutputPins(uint32_t mask, uint32_t values) = 0;
+
+    virtual void initInputPin(uint pin) = 0;
+    virtual void put(uint pin, bool value) = 0;
+
+    /// @brief Sets every pin in mask to the matching bit in values with a single write. Pins outside of mask are left
+    /// untouched.
+    virtual void putMasked(uint32_t mask, uint32_t values) = 0;
+
+    /// @brief Calls callback on every rising and falling edge of an input pin. Edges close enough together to be seen by
+    /// one interrupt are reported once, with the level after the last of them. Passing a null callback turns the
+    /// interrupt off.
+    virtual void setEdgeCallback(uint pin, EdgeCallback callback, void *context) = 0;
+
+    virtual bool get(uint pin) const = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+/// @brief A byte stream to a host, such as USB or a UART. Neither side ever waits: reads return straight away when
+/// nothing has arrived, and writes take only what can be sent without waiting.
+class AbstractSerial
+{
+public:
+    static constexpr int NoData = -1;
+
+    virtual ~AbstractSerial() = default;
+
+    /// @brief Gets the next received character, or NoData if there isn't one.
+    virtual int read() = 0;
+
+    /// @brief Sends as much of data as can be sent without waiting.
+    /// @return The number of characters taken, which can be fewer than length.
+    virtual size_t write(const char *data, size_t length) = 0;
+};
\ No newline at end of file
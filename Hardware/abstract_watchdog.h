@@ -0,0 +1,18 @@
+#pragma once
+
+#include <chrono>
+
+/// @brief A hardware watchdog that resets the board unless it is kicked often enough once enabled.
+class AbstractWatchdog
+{
+public:
+    virtual ~AbstractWatchdog() = default;
+
+    /// @brief Starts the watchdog. The board is reset if it then goes longer than timeout without a kick.
+    virtual void enable(std::chrono::milliseconds timeout) = 0;
+
+    virtual void kick() = 0;
+
+    /// @brief Whether the last reset was the watchdog running out, rather than power on or a deliberate reboot.
+    virtual bool causedReboot() const = 0;
+};
\ No newline at end of file
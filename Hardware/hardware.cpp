@@ -0,0 +1,121 @@
+#ifdef TRAFFICLIGHT_HOST
+#include "simulated_gpio.h"
+#include "virtual_clock.h"
+#include "simulated_serial.h"
+#include "simulated_flash.h"
+#include "simulated_watchdog.h"
+#else
+#include "pico_gpio.h"
+#include "pico_clock.h"
+#include "pico_serial.h"
+#include "pico_flash.h"
+#include "pico_watchdog.h"
+#endif
+
+#include "hardware.h"
+
+std::shared_ptr<AbstractGpio> Hardware::_gpio;
+std::shared_ptr<AbstractClock> Hardware::_clock;
+std::shared_ptr<AbstractSerial> Hardware::_serial;
+std::shared_ptr<AbstractFlash> Hardware::_flash;
+std::shared_ptr<AbstractWatchdog> Hardware::_watchdog;
+
+void Hardware::setUpDefaults()
+{
+    gpio();
+    clock();
+    serial();
+    flash();
+    watchdog();
+}
+
+void Hardware::setGpio(std::shared_ptr<AbstractGpio> gpio)
+{
+    _gpio = gpio;
+}
+
+void Hardware::setClock(std::shared_ptr<AbstractClock> clock)
+{
+    _clock = clock;
+}
+
+void Hardware::setSerial(std::shared_ptr<AbstractSerial> serial)
+{
+    _serial = serial;
+}
+
+void Hardware::setFlash(std::shared_ptr<AbstractFlash> flash)
+{
+    _flash = flash;
+}
+
+void Hardware::setWatchdog(std::shared_ptr<AbstractWatchdog> watchdog)
+{
+    _watchdog = watchdog;
+}
+
+AbstractGpio &Hardware::gpio()
+{
+    if (!_gpio) {
+#ifdef TRAFFICLIGHT_HOST
+        _gpio = std::make_shared<SimulatedGpio>();
+#else
+        _gpio = std::make_shared<PicoGpio>();
+#endif
+    }
+
+    return *_gpio;
+}
+
+AbstractClock &Hardware::clock()
+{
+    if (!_clock) {
+#ifdef TRAFFICLIGHT_HOST
+        _clock = std::make_shared<VirtualClock>();
+#else
+        _clock = std::make_shared<PicoClock>();
+#endif
+    }
+
+    return *_clock;
+}
+
+
+AbstractSerial &Hardware::serial()
+{
+    if (!_serial) {
+#ifdef TRAFFICLIGHT_HOST
+        _serial = std::make_shared<SimulatedSerial>();
+#else
+        _serial = std::make_shared<PicoSerial>();
+#endif
+    }
+
+    return *_serial;
+}
+
+AbstractFlash &Hardware::flash()
+{
+    if (!_flash) {
+#ifdef TRAFFICLIGHT_HOST
+        _flash = std::make_shared<SimulatedFlash>();
+#else
+        _flash = std::make_shared<PicoFlash>();
+#endif
+    }
+
+    return *_flash;
+}
+
+AbstractWatchdog &Hardware::watchdog()
+{
+    if (!_watchdog) {
+#ifdef TRAFFICLIGHT_HOST
+        _watchdog = std::make_shared<SimulatedWatchdog>();
+#else
+        _watchdog = std::make_shared<PicoWatchdog>();
+#endif
+    }
+
+    return *_watchdog;
+}
\ No newline at end of file
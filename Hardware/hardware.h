@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+
+#include "abstract_gpio.h"
+#include "abstract_clock.h"
+#include "abstract_serial.h"
+#include "abstract_flash.h"
+#include "abstract_watchdog.h"
+
+/// @brief Holds the GPIO, clock, serial, flash and watchdog backends in use. Defaults to the Pico backends on device and the simulated
+/// backends on the host, but any can be replaced before any lights are set up.
+class Hardware
+{
+public:
+    static void setUpDefaults();
+    static void setGpio(std::shared_ptr<AbstractGpio> gpio);
+    static void setClock(std::shared_ptr<AbstractClock> clock);
+    static void setSerial(std::shared_ptr<AbstractSerial> serial);
+    static void setFlash(std::shared_ptr<AbstractFlash> flash);
+    static void setWatchdog(std::shared_ptr<AbstractWatchdog> watchdog);
+
+    static AbstractGpio &gpio();
+    static AbstractClock &clock();
+    static AbstractSerial &serial();
+    static AbstractFlash &flash();
+    static AbstractWatchdog &watchdog();
+
+private:
+    static std::shared_ptr<AbstractGpio> _gpio;
+    static std::shared_ptr<AbstractClock> _clock;
+    static std::shared_ptr<AbstractSerial> _serial;
+    static std::shared_ptr<AbstractFlash> _flash;
+    static std::shared_ptr<AbstractWatchdog> _watchdog;
+};
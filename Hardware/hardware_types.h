@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef TRAFFICLIGHT_HOST
+typedef unsigned int uint;
+#else
+#include "pico/types.h"
+#endif
@@ -0,0 +1,34 @@
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "pico_clock.h"
+
+void PicoClock::sleepFor(std::chrono::milliseconds delay)
+{
+    sleep_ms(delay.count());
+}
+
+void PicoClock::sleepUntil(std::chrono::microseconds time)
+{
+    sleep_until(from_us_since_boot(time.count()));
+}
+
+bool PicoClock::waitForEvent(std::chrono::microseconds deadline)
+{
+    if (deadline == std::chrono::microseconds::max()) {
+        __wfe();
+        return false;
+    }
+
+    return best_effort_wfe_or_timeout(from_us_since_boot(deadline.count()));
+}
+
+void PicoClock::notifyEvent()
+{
+    __sev();
+}
+
+std::chrono::microseconds PicoClock::now() const
+{
+    return std::chrono::microseconds(time_us_64());
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "abstract_clock.h"
+
+class PicoClock : public AbstractClock
+{
+public:
+    void sleepFor(std::chrono::milliseconds delay) override;
+    void sleepUntil(std::chrono::microseconds time) override;
+    bool waitForEvent(std::chrono::microseconds deadline = std::chrono::microseconds::max()) override;
+    void notifyEvent() override;
+
+    std::chrono::microseconds now() const override;
+};
@@ -0,0 +1,69 @@
+#include <cstring>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+#include "pico_flash.h"
+
+PicoFlash::PicoFlash(size_t sectorCount) : _sectorCount(sectorCount), _start(PICO_FLASH_SIZE_BYTES - sectorCount * FLASH_SECTOR_SIZE)
+{
+}
+
+size_t PicoFlash::getSectorSize() const
+{
+    return FLASH_SECTOR_SIZE;
+}
+
+size_t PicoFlash::getPageSize() const
+{
+    return FLASH_PAGE_SIZE;
+}
+
+size_t PicoFlash::getSectorCount() const
+{
+    return _sectorCount;
+}
+
+void PicoFlash::read(size_t offset, void *data, size_t length) const
+{
+    memcpy(data, (const void *)(XIP_BASE + _start + offset), length);
+}
+
+void PicoFlash::erase(size_t sector)
+{
+    auto lockedOut = lockOutOtherCore();
+    auto interrupts = save_and_disable_interrupts();
+    flash_range_erase(_start + sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    restore_interrupts(interrupts);
+    releaseOtherCore(lockedOut);
+}
+
+void PicoFlash::program(size_t offset, const void *data, size_t length)
+{
+    auto lockedOut = lockOutOtherCore();
+    auto interrupts = save_and_disable_interrupts();
+    flash_range_program(_start + offset, (const uint8_t *)data, length);
+    restore_interrupts(interrupts);
+    releaseOtherCore(lockedOut);
+}
+
+bool PicoFlash::lockOutOtherCore()
+{
+    //Disabling interrupts only stops this core, so the other is parked in RAM until the flash can be read again.
+    if (!multicore_lockout_victim_is_initialized(get_core_num() ^ 1)) {
+        return false;
+    }
+
+    multicore_lockout_start_blocking();
+
+    return true;
+}
+
+void PicoFlash::releaseOtherCore(bool lockedOut)
+{
+    if (lockedOut) {
+        multicore_lockout_end_blocking();
+    }
+}
\ No newline at end of file
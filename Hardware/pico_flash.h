@@ -0,0 +1,27 @@
+#pragma once
+
+#include "abstract_flash.h"
+
+/// @brief Flash backend over the last sectors of the Pico's own flash, well clear of the program. Erasing and programming
+/// stop execution from flash, so the other core is locked out while they run, which it must allow by calling
+/// multicore_lockout_victim_init(). Otherwise they must only be done while the other core is stopped or not yet started.
+class PicoFlash : public AbstractFlash
+{
+public:
+    PicoFlash(size_t sectorCount = 4);
+
+    size_t getSectorSize() const override;
+    size_t getPageSize() const override;
+    size_t getSectorCount() const override;
+
+    void read(size_t offset, void *data, size_t length) const override;
+    void erase(size_t sector) override;
+    void program(size_t offset, const void *data, size_t length) override;
+
+private:
+    size_t _sectorCount;
+    size_t _start;
+
+    static bool lockOutOtherCore();
+    static void releaseOtherCore(bool lockedOut);
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "pico/stdlib.h"
+
+#include "pico_gpio.h"
+
+PicoGpio::EdgeCallback PicoGpio::_edgeCallbacks[PicoGpio::PinCount] = {};
+void *PicoGpio::_edgeContexts[PicoGpio::PinCount] = {};
+
+void PicoGpio::initOutputPin(uint pin)
+{
+    if (gpio_get_function(pin) == GPIO_FUNC_SIO && gpio_is_dir_out(pin)) {
+        return;
+    }
+
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+}
+
+void PicoGpio::initOutputPins(uint32_t mask, uint32_t values)
+{
+    gpio_init_mask(mask);
+    gpio_put_masked(mask, values);
+    gpio_set_dir_out_masked(mask);
+}
+
+void PicoGpio::initInputPin(uint pin)
+{
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+}
+
+void PicoGpio::put(uint pin, bool value)
+{
+    gpio_put(pin, value);
+}
+
+void PicoGpio::putMasked(uint32_t mask, uint32_t values)
+{
+    gpio_put_masked(mask, values);
+}
+
+void PicoGpio::setEdgeCallback(uint pin, EdgeCallback callback, void *context)
+{
+    if (pin >= PinCount) {
+        return;
+    }
+
+    _edgeContexts[pin] = context;
+    _edgeCallbacks[pin] = callback;
+
+    gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, callback != nullptr, &PicoGpio::onGpioInterrupt);
+}
+
+bool PicoGpio::get(uint pin) const
+{
+    return gpio_get(pin);
+}
+
+void PicoGpio::onGpioInterrupt(uint pin, uint32_t events)
+{
+    auto timestamp = std::chrono::microseconds(time_us_64());
+
+    if (pin < PinCount && (events & (GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL)) != 0 && _edgeCallbacks[pin]) {
+        _edgeCallbacks[pin](pin, gpio_get(pin), timestamp, _edgeContexts[pin]);
+    }
+}
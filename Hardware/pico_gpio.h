@@ -0,0 +1,24 @@
+#pragma once
+
+#include "abstract_gpio.h"
+
+class PicoGpio : public AbstractGpio
+{
+public:
+    void initOutputPin(uint pin) override;
+    void initOutputPins(uint32_t mask, uint32_t values) override;
+    void initInputPin(uint pin) override;
+    void put(uint pin, bool value) override;
+    void putMasked(uint32_t mask, uint32_t values) override;
+    void setEdgeCallback(uint pin, EdgeCallback callback, void *context) override;
+
+    bool get(uint pin) const override;
+
+private:
+    static constexpr uint PinCount = 32;
+
+    static EdgeCallback _edgeCallbacks[PinCount];
+    static void *_edgeContexts[PinCount];
+
+    static void onGpioInterrupt(uint pin, uint32_t events);
+};
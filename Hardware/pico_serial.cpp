@@ -0,0 +1,22 @@
+#include "pico/stdlib.h"
+
+#include "pico_serial.h"
+
+int PicoSerial::read()
+{
+    auto character = getchar_timeout_us(0);
+
+    return character == PICO_ERROR_TIMEOUT ? NoData : character;
+}
+
+size_t PicoSerial::write(const char *data, size_t length)
+{
+    size_t written = 0;
+
+    //USB never waits, so the UART FIFO filling up is the only thing that could hold up a write.
+    while (written < length && uart_is_writable(uart_default)) {
+        putchar_raw(data[written++]);
+    }
+
+    return written;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "abstract_serial.h"
+
+/// @brief Serial backend over the Pico's stdio, which is USB and the default UART. Needs
+/// PICO_STDIO_USB_STDOUT_TIMEOUT_US set to 0 so USB output is dropped rather than waited on when the host stops reading.
+class PicoSerial : public AbstractSerial
+{
+public:
+    int read() override;
+    size_t write(const char *data, size_t length) override;
+};
\ No newline at end of file
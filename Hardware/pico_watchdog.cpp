@@ -0,0 +1,19 @@
+#include "hardware/watchdog.h"
+
+#include "pico_watchdog.h"
+
+void PicoWatchdog::enable(std::chrono::milliseconds timeout)
+{
+    watchdog_enable((uint32_t)timeout.count(), true);
+}
+
+void PicoWatchdog::kick()
+{
+    watchdog_update();
+}
+
+bool PicoWatchdog::causedReboot() const
+{
+    //Only counts resets from a watchdog started by enable(), not reboots asked for through it such as by picotool.
+    return watchdog_enable_caused_reboot();
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "abstract_watchdog.h"
+
+/// @brief Watchdog backend over the RP2040's watchdog. It is paused while a debugger has the cores halted.
+class PicoWatchdog : public AbstractWatchdog
+{
+public:
+    void enable(std::chrono::milliseconds timeout) override;
+    void kick() override;
+
+    bool causedReboot() const override;
+};
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "simulated_flash.h"
+
+SimulatedFlash::SimulatedFlash(size_t sectorCount, const std::string &path) :
+    _memory(sectorCount * SectorSize, 0xff),
+    _eraseCounts(sectorCount, 0),
+    _path(path)
+{
+    if (_path.empty()) {
+        return;
+    }
+
+    if (auto file = fopen(_path.c_str(), "rb")) {
+        auto read = fread(_memory.data(), 1, _memory.size(), file);
+        fclose(file);
+
+        //A short or missing file reads as erased flash.
+        std::fill(_memory.begin() + read, _memory.end(), 0xff);
+    }
+}
+
+size_t SimulatedFlash::getSectorSize() const
+{
+    return SectorSize;
+}
+
+size_t SimulatedFlash::getPageSize() const
+{
+    return PageSize;
+}
+
+size_t SimulatedFlash::getSectorCount() const
+{
+    return _eraseCounts.size();
+}
+
+void SimulatedFlash::read(size_t offset, void *data, size_t length) const
+{
+    if (offset + length <= _memory.size()) {
+        memcpy(data, _memory.data() + offset, length);
+    }
+}
+
+void SimulatedFlash::erase(size_t sector)
+{
+    if (sector >= _eraseCounts.size()) {
+        return;
+    }
+
+    auto erased = usePower(SectorSize);
+    std::fill_n(_memory.begin() + sector * SectorSize, erased, 0xff);
+
+    if (erased > 0) {
+        ++_eraseCounts[sector];
+    }
+
+    save();
+}
+
+void SimulatedFlash::program(size_t offset, const void *data, size_t length)
+{
+    if (offset % PageSize != 0 || length % PageSize != 0 || offset + length > _memory.size()) {
+        return;
+    }
+
+    auto bytes = (const uint8_t *)data;
+    auto programmed = usePower(length);
+
+    for (size_t index = 0; index < programmed; ++index) {
+        _memory[offset + index] &= bytes[index];
+    }
+
+    save();
+}
+
+void SimulatedFlash::cutPowerAfter(size_t bytes)
+{
+    _bytesUntilPowerCut = bytes;
+}
+
+void SimulatedFlash::restorePower()
+{
+    _bytesUntilPowerCut = NoPowerCut;
+    _powered = true;
+}
+
+bool SimulatedFlash::isPowered() const
+{
+    return _powered;
+}
+
+uint32_t SimulatedFlash::getEraseCount(size_t sector) const
+{
+    return sector < _eraseCounts.size() ? _eraseCounts[sector] : 0;
+}
+
+size_t SimulatedFlash::usePower(size_t bytes)
+{
+    if (!_powered) {
+        return 0;
+    }
+
+    if (_bytesUntilPowerCut == NoPowerCut) {
+        return bytes;
+    }
+
+    if (bytes < _bytesUntilPowerCut) {
+        _bytesUntilPowerCut -= bytes;
+        return bytes;
+    }
+
+    auto allowed = _bytesUntilPowerCut;
+    _bytesUntilPowerCut = 0;
+    _powered = false;
+
+    return allowed;
+}
+
+void SimulatedFlash::save() const
+{
+    if (_path.empty()) {
+        return;
+    }
+
+    if (auto file = fopen(_path.c_str(), "wb")) {
+        fwrite(_memory.data(), 1, _memory.size(), file);
+        fclose(file);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "abstract_flash.h"
+
+/// @brief Host flash backend with the same erase and program rules as NOR flash. Kept in memory, or in a file when given
+/// a path so it lasts between runs. The power can be cut after a number of bytes have been erased or programmed, leaving
+/// that operation half done and ignoring everything after it until the power is restored, to check that whatever was
+/// being written can't be mistaken for good data.
+class SimulatedFlash : public AbstractFlash
+{
+public:
+    static constexpr size_t SectorSize = 4096;
+    static constexpr size_t PageSize = 256;
+    static constexpr size_t NoPowerCut = (size_t)-1;
+
+    SimulatedFlash(size_t sectorCount = 4, const std::string &path = "");
+
+    size_t getSectorSize() const override;
+    size_t getPageSize() const override;
+    size_t getSectorCount() const override;
+
+    void read(size_t offset, void *data, size_t length) const override;
+    void erase(size_t sector) override;
+    void program(size_t offset, const void *data, size_t length) override;
+
+    /// @brief Cuts the power once the given number of bytes have been erased or programmed from now.
+    void cutPowerAfter(size_t bytes);
+    void restorePower();
+
+    bool isPowered() const;
+
+    uint32_t getEraseCount(size_t sector) const;
+
+private:
+    std::vector<uint8_t> _memory;
+    std::vector<uint32_t> _eraseCounts;
+    std::string _path;
+
+    size_t _bytesUntilPowerCut = NoPowerCut;
+    bool _powered = true;
+
+    /// @brief Counts down to the power cut.
+    /// @return How many of the bytes can be written before the power goes.
+    size_t usePower(size_t bytes);
+    void save() const;
+};
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "hardware.h"
+
+#include "simulated_gpio.h"
+
+void SimulatedGpio::initOutputPin(uint pin)
+{
+    if (isValidPin(pin) && !isOutput(pin)) {
+        _outputs |= 1u << pin;
+        _state &= ~(1u << pin);
+    }
+}
+
+void SimulatedGpio::initOutputPins(uint32_t mask, uint32_t values)
+{
+    _state = (_state & ~mask) | (values & mask);
+    _outputs |= mask;
+
+    ++_writeCount;
+}
+
+void SimulatedGpio::initInputPin(uint pin)
+{
+    if (isValidPin(pin)) {
+        _outputs &= ~(1u << pin);
+        _state &= ~(1u << pin);
+    }
+}
+
+void SimulatedGpio::put(uint pin, bool value)
+{
+    if (isValidPin(pin)) {
+        if (value) {
+            _state |= 1u << pin;
+        }
+        else {
+            _state &= ~(1u << pin);
+        }
+    }
+
+    ++_writeCount;
+}
+
+void SimulatedGpio::putMasked(uint32_t mask, uint32_t values)
+{
+    _state = (_state & ~mask) | (values & mask);
+
+    ++_writeCount;
+}
+
+void SimulatedGpio::setEdgeCallback(uint pin, EdgeCallback callback, void *context)
+{
+    if (isValidPin(pin)) {
+        _edgeContexts[pin] = context;
+        _edgeCallbacks[pin] = callback;
+    }
+}
+
+void SimulatedGpio::setInput(uint pin, bool value)
+{
+    if (isValidPin(pin) && !isOutput(pin) && get(pin) != value) {
+        if (value) {
+            _state |= 1u << pin;
+        }
+        else {
+            _state &= ~(1u << pin);
+        }
+
+        if (_edgeCallbacks[pin]) {
+            _edgeCallbacks[pin](pin, value, Hardware::clock().now(), _edgeContexts[pin]);
+        }
+    }
+}
+
+void SimulatedGpio::resetWriteCount()
+{
+    _writeCount = 0;
+}
+
+bool SimulatedGpio::get(uint pin) const
+{
+    return isValidPin(pin) && (_state & (1u << pin)) != 0;
+}
+
+bool SimulatedGpio::isOutput(uint pin) const
+{
+    return isValidPin(pin) && (_outputs & (1u << pin)) != 0;
+}
+
+uint32_t SimulatedGpio::getState() const
+{
+    return _state;
+}
+
+uint64_t SimulatedGpio::getWriteCount() const
+{
+    return _writeCount;
+}
+
+bool SimulatedGpio::isValidPin(uint pin) const
+{
+    return pin < PinCount;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "abstract_gpio.h"
+
+/// @brief Host GPIO backend. Keeps the state of the 32 pins of a single bank in memory so it can be inspected, and
+/// counts writes so the cost of a step can be measured. Edges on inputs set with setInput() call any edge callback
+/// straight away, stamped with the current Hardware::clock() time.
+class SimulatedGpio : public AbstractGpio
+{
+public:
+    static constexpr uint PinCount = 32;
+
+    void initOutputPin(uint pin) override;
+    void initOutputPins(uint32_t mask, uint32_t values) override;
+    void initInputPin(uint pin) override;
+    void put(uint pin, bool value) override;
+    void putMasked(uint32_t mask, uint32_t values) override;
+    void setEdgeCallback(uint pin, EdgeCallback callback, void *context) override;
+    void setInput(uint pin, bool value);
+    void resetWriteCount();
+
+    bool get(uint pin) const override;
+    bool isOutput(uint pin) const;
+
+    uint32_t getState() const;
+    uint64_t getWriteCount() const;
+
+private:
+    uint32_t _state = 0;
+    uint32_t _outputs = 0;
+    uint64_t _writeCount = 0;
+
+    EdgeCallback _edgeCallbacks[PinCount] = {};
+    void *_edgeContexts[PinCount] = {};
+
+    bool isValidPin(uint pin) const;
+};
@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "simulated_serial.h"
+
+int SimulatedSerial::read()
+{
+    if (_input.empty()) {
+        return NoData;
+    }
+
+    auto character = _input.front();
+    _input.pop_front();
+
+    return (unsigned char)character;
+}
+
+size_t SimulatedSerial::write(const char *data, size_t length)
+{
+    auto written = std::min(length, _writeLimit);
+    _output.append(data, written);
+
+    return written;
+}
+
+void SimulatedSerial::feed(const std::string &input)
+{
+    _input.insert(_input.end(), input.begin(), input.end());
+}
+
+void SimulatedSerial::setWriteLimit(size_t limit)
+{
+    _writeLimit = limit;
+}
+
+std::string SimulatedSerial::takeOutput()
+{
+    std::string output;
+    output.swap(_output);
+
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <deque>
+#include <string>
+
+#include "abstract_serial.h"
+
+/// @brief Host serial backend. Input is fed in by hand and output is collected so it can be printed. A write limit makes
+/// it behave like a slow host, taking only so many characters per write, or a disconnected one when the limit is 0.
+class SimulatedSerial : public AbstractSerial
+{
+public:
+    static constexpr size_t Unlimited = (size_t)-1;
+
+    int read() override;
+    size_t write(const char *data, size_t length) override;
+
+    void feed(const std::string &input);
+    void setWriteLimit(size_t limit);
+
+    /// @brief Gets everything written since the last call.
+    std::string takeOutput();
+
+private:
+    std::deque<char> _input;
+    std::string _output;
+    size_t _writeLimit = Unlimited;
+};
\ No newline at end of file
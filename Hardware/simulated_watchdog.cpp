@@ -0,0 +1,44 @@
+#include "hardware.h"
+
+#include "simulated_watchdog.h"
+
+void SimulatedWatchdog::enable(std::chrono::milliseconds timeout)
+{
+    _enabled = true;
+    _expired = false;
+    _timeout = timeout;
+    _lastKick = Hardware::clock().now();
+}
+
+void SimulatedWatchdog::kick()
+{
+    //A kick after the watchdog has run out is too late, as the board would already have been reset.
+    _expired = hasExpired();
+    _lastKick = Hardware::clock().now();
+    ++_kickCount;
+}
+
+bool SimulatedWatchdog::causedReboot() const
+{
+    return _causedReboot;
+}
+
+void SimulatedWatchdog::setCausedReboot(bool causedReboot)
+{
+    _causedReboot = causedReboot;
+}
+
+bool SimulatedWatchdog::isEnabled() const
+{
+    return _enabled;
+}
+
+bool SimulatedWatchdog::hasExpired() const
+{
+    return _expired || (_enabled && Hardware::clock().now() - _lastKick > _timeout);
+}
+
+uint32_t SimulatedWatchdog::getKickCount() const
+{
+    return _kickCount;
+}
\ No newline at end of file
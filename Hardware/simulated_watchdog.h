@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "abstract_watchdog.h"
+
+/// @brief Host watchdog backend. Nothing is reset; instead whether the watchdog would have run out is worked out from
+/// the current Hardware::clock() time, and the reason for the last reset can be set by hand.
+class SimulatedWatchdog : public AbstractWatchdog
+{
+public:
+    void enable(std::chrono::milliseconds timeout) override;
+    void kick() override;
+
+    bool causedReboot() const override;
+    void setCausedReboot(bool causedReboot);
+
+    bool isEnabled() const;
+
+    /// @brief Whether the board would have been reset by now.
+    bool hasExpired() const;
+
+    uint32_t getKickCount() const;
+
+private:
+    bool _enabled = false;
+    bool _causedReboot = false;
+    bool _expired = false;
+    uint32_t _kickCount = 0;
+
+    std::chrono::milliseconds _timeout = std::chrono::milliseconds(0);
+    std::chrono::microseconds _lastKick = std::chrono::microseconds(0);
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "virtual_clock.h"
+
+void VirtualClock::sleepFor(std::chrono::milliseconds delay)
+{
+    advance(delay);
+}
+
+void VirtualClock::sleepUntil(std::chrono::microseconds time)
+{
+    if (time > _now.load()) {
+        _now = time;
+    }
+}
+
+bool VirtualClock::waitForEvent(std::chrono::microseconds deadline)
+{
+    std::unique_lock<std::mutex> lock(_eventMutex);
+
+    if (!_eventPending) {
+        if (deadline != std::chrono::microseconds::max()) {
+            sleepUntil(deadline);
+            return true;
+        }
+
+        _eventCondition.wait(lock, [this]() { return _eventPending; });
+    }
+
+    _eventPending = false;
+
+    return false;
+}
+
+void VirtualClock::notifyEvent()
+{
+    {
+        std::lock_guard<std::mutex> lock(_eventMutex);
+        _eventPending = true;
+    }
+
+    _eventCondition.notify_all();
+}
+
+void VirtualClock::advance(std::chrono::microseconds time)
+{
+    _now = _now.load() + time;
+}
+
+void VirtualClock::reset()
+{
+    _now = std::chrono::microseconds(0);
+}
+
+std::chrono::microseconds VirtualClock::now() const
+{
+    return _now;
+}
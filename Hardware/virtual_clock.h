@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "abstract_clock.h"
+
+/// @brief Host clock that never blocks. Sleeping just moves the virtual time forward, so a full cycle of any system runs
+/// as fast as the code around it allows. The time can be read from other threads, but only one thread should sleep on it.
+/// Waiting for an event with a deadline jumps straight to the deadline unless an event is already pending, while waiting
+/// with no deadline blocks on a condition variable until another thread calls notifyEvent().
+class VirtualClock : public AbstractClock
+{
+public:
+    void sleepFor(std::chrono::milliseconds delay) override;
+    void sleepUntil(std::chrono::microseconds time) override;
+    bool waitForEvent(std::chrono::microseconds deadline = std::chrono::microseconds::max()) override;
+    void notifyEvent() override;
+    void advance(std::chrono::microseconds time);
+    void reset();
+
+    std::chrono::microseconds now() const override;
+
+private:
+    std::atomic<std::chrono::microseconds> _now = std::chrono::microseconds(0);
+
+    bool _eventPending = false;
+
+    std::mutex _eventMutex;
+    std::condition_variable _eventCondition;
+};
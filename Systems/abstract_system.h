@@ -1,36 +1,208 @@
 #pragma once
 
 #include <chrono>
-#include <map>
+#include <cstddef>
+#include <memory>
 
+#include "runnable_system.h"
+#include "timing_profile.h"
+#include "timing_plan_schedule.h"
+#include "../triple_buffer.h"
+
+/// @brief Base for systems with a set of timings, held as a TimingProfile. setTiming changes the profile in use
+/// directly, so it must be called from the core running the system. Any other core can retune a running system by
+/// publishing a whole profile, which the system picks up at its next phase boundary. A TimingPlanSchedule can also swap the
+/// profile by time of day. The profile in use is mirrored back out at phase boundaries so another core can read it, and
+/// retune single timings by index.
 template<typename TimingEnum>
-class AbstractSystem
+class AbstractSystem : public RunnableSystem
 {
 public:
-    virtual void run() = 0; 
+    using Timings = TimingProfile<TimingEnum>;
+    using Schedule = TimingPlanSchedule<TimingEnum>;
+
+    static constexpr size_t TimingCount = Timings::TimingCount;
+    static constexpr int MaximumTimingGroups = Timings::MaximumGroups;
+
+    /// @brief The longest any timing can be published as through publishTiming().
+    static constexpr std::chrono::milliseconds MaximumTiming = std::chrono::hours(1);
+
+    /// @brief A profile holding the standard timings, for a writer to start from before publishing.
+    Timings getStandardTimingProfile() const
+    {
+        Timings profile;
+
+        for (size_t timing = 0; timing < TimingCount; ++timing) {
+            profile.set(static_cast<TimingEnum>(timing), getStandardTiming(static_cast<TimingEnum>(timing)));
+        }
+
+        return profile;
+    }
+
+    /// @brief Publishes a new set of timings without locking. Only one core or thread may publish. The profile
+    /// replaces every timing, including any set with setTiming, once the system reaches its next phase boundary. With a
+    /// TimingPlanSchedule, the next switch point replaces it in turn with the plan's timings.
+    void publishTimings(const Timings &profile)
+    {
+        _timings.publish(profile);
+    }
+
+    /// @brief Switches between the schedule's plans at cycle boundaries. Set from the core running the system.
+    void setTimingSchedule(std::shared_ptr<Schedule> schedule)
+    {
+        _schedule = schedule;
+        _activePlan = Schedule::NoPlan;
+    }
+
+    /// @brief The index of the plan from the schedule currently in use, or Schedule::NoPlan.
+    size_t getActivePlan() const
+    {
+        return _activePlan;
+    }
+
+    size_t getTimingCount() const override
+    {
+        return TimingCount;
+    }
+
+    const char *getTimingName(size_t timing) const override
+    {
+        return timing < TimingCount ? describeTiming(static_cast<TimingEnum>(timing)) : "";
+    }
+
+    bool readTiming(size_t timing, int groupId, std::chrono::milliseconds &time) override
+    {
+        if (timing >= TimingCount || groupId < -1 || groupId >= MaximumTimingGroups) {
+            return false;
+        }
+
+        _timingsInUse.update();
+        time = _timingsInUse.read().get(static_cast<TimingEnum>(timing), groupId);
+
+        return true;
+    }
+
+    /// @brief Publishes a change to one timing on top of those in use. Like publishTimings(), the change only lasts
+    /// until the next switch point of any TimingPlanSchedule, which puts back the plan's own value.
+    bool publishTiming(size_t timing, int groupId, std::chrono::milliseconds time) override
+    {
+        std::chrono::milliseconds minimum;
+        std::chrono::milliseconds maximum;
+        if (!getTimingLimits(timing, minimum, maximum) || time < minimum || time > maximum) {
+            return false;
+        }
+
+        //Builds on the last publish until the system has picked it up, so quick changes in a row aren't lost.
+        if (_timingsInUse.update() || !_hasDraft) {
+            _draft = _timingsInUse.read();
+            _hasDraft = true;
+        }
+
+        if (!_draft.set(static_cast<TimingEnum>(timing), time, groupId)) {
+            return false;
+        }
+
+        publishTimings(_draft);
+
+        return true;
+    }
+
+    bool getTimingLimits(size_t timing, std::chrono::milliseconds &minimum, std::chrono::milliseconds &maximum) const override
+    {
+        if (timing >= TimingCount) {
+            return false;
+        }
+
+        minimum = getMinimumTiming(static_cast<TimingEnum>(timing));
+        maximum = MaximumTiming;
+
+        return true;
+    }
 
 protected:
-    virtual void setTimingInternal(TimingEnum timingEnum, std::chrono::milliseconds time, int groupId = -1)
+    /// @brief Fills every timing from getStandardTiming. Call from the derived constructor, as it can't be called from here.
+    void setUpStandardTimings()
     {
-        _timings[groupId][timingEnum] = time.count();
-    };
+        _timings.reset(getStandardTimingProfile());
+        _timingsInUse.reset(_timings.read());
+        _timingsInUseChanged = false;
+    }
 
-    virtual std::chrono::milliseconds getTiming(TimingEnum timing, int groupId = -1) const
+    /// @brief Picks up the latest published timings. Call at phase boundaries, before reading the timings for the phase.
+    /// @return True if new timings were picked up.
+    bool updateTimings()
     {
-        auto foundGroup = _timings.find(groupId);
-        if (foundGroup != _timings.end()) {
-            auto timingsMap = foundGroup->second;
-            auto foundTiming = timingsMap.find(timing);
-            if (foundTiming != timingsMap.end()) {
-                return std::chrono::milliseconds(foundTiming->second);
-            }
+        auto updated = _timings.update();
+
+        if (updated || _timingsInUseChanged) {
+            _timingsInUse.publish(_timings.read());
+            _timingsInUseChanged = false;
+        }
+
+        return updated;
+    }
+
+    /// @brief Switches to the scheduled plan for the time of day if it has changed. Call at cycle boundaries. The plan
+    /// replaces the timings in use, including published ones, until the next publish or switch point.
+    /// @return True if the plan changed.
+    bool updateScheduledTimings()
+    {
+        if (!_schedule) {
+            return false;
+        }
+
+        auto plan = _schedule->getActivePlan();
+        if (plan == _activePlan || plan == Schedule::NoPlan) {
+            return false;
         }
-        
-        return getStandardTiming(timing);
+
+        _activePlan = plan;
+        _timings.read() = _schedule->getTimings(plan);
+        _timingsInUseChanged = true;
+
+        return true;
+    }
+
+    /// @brief Sets a timing for a group, or for the whole system when groupId is -1.
+    /// @return False if the timing or group is out of range, in which case nothing changes. Only groups below
+    /// MaximumTimingGroups can have their own timings.
+    bool setTimingInternal(TimingEnum timingEnum, std::chrono::milliseconds time, int groupId = -1)
+    {
+        if (!_timings.read().set(timingEnum, time, groupId)) {
+            return false;
+        }
+
+        _timingsInUseChanged = true;
+
+        return true;
+    };
+
+    std::chrono::milliseconds getTiming(TimingEnum timing, int groupId = -1) const
+    {
+        return _timings.read().get(timing, groupId);
     };
 
     virtual std::chrono::milliseconds getStandardTiming(TimingEnum timing) const = 0;
 
-private:    
-    std::map<int, std::map<TimingEnum, int>> _timings;
+    /// @brief The shortest a timing can be published as, used by getTimingLimits(). Override for timings such as
+    /// clearance times that would be unsafe at 0.
+    virtual std::chrono::milliseconds getMinimumTiming(TimingEnum timing) const
+    {
+        return std::chrono::milliseconds(0);
+    }
+
+    /// @brief A short name for a timing, used by getTimingName().
+    virtual const char *describeTiming(TimingEnum timing) const
+    {
+        return "";
+    }
+
+private:
+    TripleBuffer<Timings> _timings;
+    TripleBuffer<Timings> _timingsInUse;
+    Timings _draft;
+    bool _hasDraft = false;
+    bool _timingsInUseChanged = false;
+    std::shared_ptr<Schedule> _schedule;
+    size_t _activePlan = Schedule::NoPlan;
 };
\ No newline at end of file
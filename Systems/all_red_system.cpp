@@ -0,0 +1,55 @@
+#include "../trafficlight.h"
+#include "../trafficlight_group.h"
+
+#include "all_red_system.h"
+
+AllRedSystem::AllRedSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+{
+    setUpStandardTimings();
+
+    _group = std::make_shared<TrafficLightGroup>(trafficLights);
+}
+
+bool AllRedSystem::setTiming(AllRedSystemTimings timing, std::chrono::milliseconds time)
+{
+    return setTimingInternal(timing, time);
+}
+
+void AllRedSystem::start()
+{
+    updateTimings();
+
+    _held = false;
+}
+
+SystemStep AllRedSystem::advance()
+{
+    if (_held) {
+        return SystemStep::finished();
+    }
+
+    _group->showLights((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+    _held = true;
+
+    return SystemStep::delayFor(getTiming(AllRedSystemTimings::HoldTime));
+}
+
+const char *AllRedSystem::getPhaseName(uint8_t phase) const
+{
+    return "all-red";
+}
+
+bool AllRedSystem::isAtSafePoint() const
+{
+    return _held;
+}
+
+std::chrono::milliseconds AllRedSystem::getStandardTiming(AllRedSystemTimings timing) const
+{
+    return std::chrono::seconds(1);
+}
+
+const char *AllRedSystem::describeTiming(AllRedSystemTimings timing) const
+{
+    return timing == AllRedSystemTimings::HoldTime ? "hold" : "";
+}
\ No newline at end of file
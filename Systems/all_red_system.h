@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "abstract_system.h"
+
+class TrafficLight;
+class TrafficLightGroup;
+
+enum class AllRedSystemTimings
+{
+    HoldTime, //How long each cycle holds the lights on red
+    Count //The number of timings, not a timing itself
+};
+
+/// @brief Holds every vehicle and crossing light on red, such as while a junction is being worked on. Each cycle is a
+/// single hold, so a SystemSupervisor can hand over to it and away from it without any lights changing in between.
+class AllRedSystem : public AbstractSystem<AllRedSystemTimings>
+{
+public:
+    AllRedSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights);
+
+    bool setTiming(AllRedSystemTimings timing, std::chrono::milliseconds time);
+    void start() override;
+
+    SystemStep advance() override;
+
+    const char *getPhaseName(uint8_t phase) const override;
+    bool isAtSafePoint() const override;
+
+private:
+    std::shared_ptr<TrafficLightGroup> _group;
+
+    bool _held = false;
+
+    std::chrono::milliseconds getStandardTiming(AllRedSystemTimings timing) const override;
+    const char *describeTiming(AllRedSystemTimings timing) const override;
+};
\ No newline at end of file
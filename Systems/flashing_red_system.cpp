@@ -0,0 +1,73 @@
+#include "../trafficlight.h"
+#include "../trafficlight_group.h"
+#include "../sequence.h"
+#include "../controller.h"
+#include "../conflict_monitor.h"
+
+#include "flashing_red_system.h"
+
+FlashingRedSystem::FlashingRedSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+{
+    setUpStandardTimings();
+
+    _group = std::make_shared<TrafficLightGroup>(trafficLights);
+    _flashSequence = std::make_shared<Sequence>();
+    _flashController = std::make_shared<Controller>();
+
+    _flashController->setConflictMatrix(std::make_shared<ConflictMatrix>(std::vector<std::shared_ptr<TrafficLightGroup>> { _group }));
+    _flashController->addTrafficLightGroup(_group, 0);
+    _flashController->addSequence(_flashSequence, 0);
+}
+
+bool FlashingRedSystem::setTiming(FlashingRedSystemTimings timing, std::chrono::milliseconds time)
+{
+    return setTimingInternal(timing, time);
+}
+
+void FlashingRedSystem::start()
+{
+    updateTimings();
+
+    //Only rebuilt when the interval changes, so the flashes don't keep recompiling the controller.
+    auto flashInterval = getTiming(FlashingRedSystemTimings::FlashInterval);
+    if (flashInterval != _flashInterval) {
+        _flashSequence->clear();
+        _flashSequence->add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing), flashInterval);
+        _flashSequence->add(TrafficLight::Light::RedCrossing, flashInterval);
+        _flashInterval = flashInterval;
+    }
+
+    _flashController->start();
+}
+
+SystemStep FlashingRedSystem::advance()
+{
+    std::chrono::milliseconds delay;
+
+    if (_flashController->advance(delay)) {
+        return SystemStep::delayFor(delay);
+    }
+
+    return SystemStep::finished();
+}
+
+const char *FlashingRedSystem::getPhaseName(uint8_t phase) const
+{
+    return "flashing-red";
+}
+
+bool FlashingRedSystem::isAtSafePoint() const
+{
+    //Only while the red is lit, as the vehicle lights are dark between flashes.
+    return _flashController->getShownLights() == (TrafficLight::Light::Red | TrafficLight::Light::RedCrossing);
+}
+
+std::chrono::milliseconds FlashingRedSystem::getStandardTiming(FlashingRedSystemTimings timing) const
+{
+    return std::chrono::milliseconds(500);
+}
+
+const char *FlashingRedSystem::describeTiming(FlashingRedSystemTimings timing) const
+{
+    return timing == FlashingRedSystemTimings::FlashInterval ? "flash" : "";
+}
\ No newline at end of file
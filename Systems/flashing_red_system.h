@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "abstract_system.h"
+
+class TrafficLight;
+class TrafficLightGroup;
+class Sequence;
+class Controller;
+
+enum class FlashingRedSystemTimings
+{
+    FlashInterval, //How long the red lights are on, then off, for
+    Count //The number of timings, not a timing itself
+};
+
+/// @brief Flashes every vehicle light red with the crossing lights held on red, so every approach treats the junction as
+/// a stop. Red shows from the very first step, which makes it the safe state to fall back to, such as after a stall.
+/// Each cycle is a single flash.
+class FlashingRedSystem : public AbstractSystem<FlashingRedSystemTimings>
+{
+public:
+    FlashingRedSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights);
+
+    bool setTiming(FlashingRedSystemTimings timing, std::chrono::milliseconds time);
+    void start() override;
+
+    SystemStep advance() override;
+
+    const char *getPhaseName(uint8_t phase) const override;
+    bool isAtSafePoint() const override;
+
+private:
+    std::shared_ptr<TrafficLightGroup> _group;
+    std::shared_ptr<Sequence> _flashSequence;
+    std::shared_ptr<Controller> _flashController;
+
+    std::chrono::milliseconds _flashInterval = std::chrono::milliseconds(0);
+
+    std::chrono::milliseconds getStandardTiming(FlashingRedSystemTimings timing) const override;
+    const char *describeTiming(FlashingRedSystemTimings timing) const override;
+};
\ No newline at end of file
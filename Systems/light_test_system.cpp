@@ -5,24 +5,87 @@
 
 #include "light_test_system.h"
 
-void LightTestSystem::setTiming(LightTestSystemTimings timing, std::chrono::milliseconds delay)
+LightTestSystem::LightTestSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
 {
-    setTimingInternal(timing, delay);
+    setUpStandardTimings();
+
+    _trafficLights = trafficLights;
+
+    setUp();
+}
+
+bool LightTestSystem::setTiming(LightTestSystemTimings timing, std::chrono::milliseconds delay)
+{
+    return setTimingInternal(timing, delay);
 }
 
-void LightTestSystem::run()
+void LightTestSystem::start()
 {
-    auto testController = std::make_shared<Controller>();
-    auto trafficLightGroup = std::make_shared<TrafficLightGroup>(_trafficLights);
-    auto testSequence = std::make_shared<TestSequence>(getTiming(LightTestSystemTimings::AnimationDelay));
+    updateTimings();
 
-    testController->addTrafficLightGroup(trafficLightGroup, 0);
-    testController->addSequence(testSequence, 0);
+    _testSequence->set(getTiming(LightTestSystemTimings::AnimationDelay));
+    _testController->start();
 
-    testController->run();
+    _safePointRequested = false;
+    _showingRed = false;
+}
+
+SystemStep LightTestSystem::advance()
+{
+    std::chrono::milliseconds delay;
+
+    //The test ends on every light off, so a safe point is reached by stopping it and showing red everywhere instead.
+    if (_safePointRequested) {
+        if (_showingRed) {
+            return SystemStep::finished();
+        }
+
+        _group->showLights((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+        _showingRed = true;
+
+        return SystemStep::delayFor(getTiming(LightTestSystemTimings::AnimationDelay));
+    }
+
+    if (_testController->advance(delay)) {
+        return SystemStep::delayFor(delay);
+    }
+
+    return SystemStep::finished();
+}
+
+bool LightTestSystem::isAtSafePoint() const
+{
+    return _showingRed;
+}
+
+bool LightTestSystem::isHoldingStep() const
+{
+    //Every step only holds the lamps on for a look, so none is a clearance.
+    return !_showingRed;
+}
+
+void LightTestSystem::requestSafePoint()
+{
+    _safePointRequested = true;
+}
+
+void LightTestSystem::setUp()
+{
+    //Every light is lit at once as part of the test, so it isn't checked for conflicts.
+    _testController = std::make_shared<Controller>();
+    _testSequence = std::make_shared<TestSequence>();
+    _group = std::make_shared<TrafficLightGroup>(_trafficLights);
+
+    _testController->addTrafficLightGroup(_group, 0);
+    _testController->addSequence(_testSequence, 0);
 }
 
 std::chrono::milliseconds LightTestSystem::getStandardTiming(LightTestSystemTimings timing) const
 {
     return std::chrono::milliseconds(150);
+}
+
+const char *LightTestSystem::describeTiming(LightTestSystemTimings timing) const
+{
+    return timing == LightTestSystemTimings::AnimationDelay ? "animation" : "";
 }
\ No newline at end of file
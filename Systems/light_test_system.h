@@ -6,22 +6,42 @@
 #include "abstract_system.h"
 
 class TrafficLight;
+class TrafficLightGroup;
+class TestSequence;
+class Controller;
 
 enum class LightTestSystemTimings
 {
-    AnimationDelay
+    AnimationDelay,
+    Count //The number of timings, not a timing itself
 };
 
 class LightTestSystem : public AbstractSystem<LightTestSystemTimings>
 {
 public:
-    LightTestSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights) { _trafficLights = trafficLights; }
+    LightTestSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights);
 
-    void setTiming(LightTestSystemTimings timing, std::chrono::milliseconds delay);
-    void run() override;
+    bool setTiming(LightTestSystemTimings timing, std::chrono::milliseconds delay);
+    void start() override;
+
+    SystemStep advance() override;
+
+    bool isAtSafePoint() const override;
+    bool isHoldingStep() const override;
+    void requestSafePoint() override;
 
 private:
     std::vector<std::shared_ptr<TrafficLight>> _trafficLights;
+    std::shared_ptr<TrafficLightGroup> _group;
+
+    std::shared_ptr<Controller> _testController;
+    std::shared_ptr<TestSequence> _testSequence;
+
+    bool _safePointRequested = false;
+    bool _showingRed = false;
+
+    void setUp();
 
     std::chrono::milliseconds getStandardTiming(LightTestSystemTimings timing) const override;
+    const char *describeTiming(LightTestSystemTimings timing) const override;
 };
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include <cmath>
 
 #include "../controller.h"
+#include "../conflict_monitor.h"
 #include "../common_sequences.h"
+#include "../common_fixed_sequences.h"
 #include "../trafficlight.h"
 #include "../trafficlight_group.h"
 
@@ -9,6 +11,8 @@
 
 NAStopGiveWaySystem::NAStopGiveWaySystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights, unsigned int priorityLightId)
 {
+    setUpStandardTimings();
+
     auto priorityGroup = std::make_shared<TrafficLightGroup>();
     auto stopGroup = std::make_shared<TrafficLightGroup>();
 
@@ -28,21 +32,88 @@ NAStopGiveWaySystem::NAStopGiveWaySystem(std::vector<std::shared_ptr<TrafficLigh
     }
 
     setGroups(priorityGroup, stopGroup);
+    setUp();
 }
 
 NAStopGiveWaySystem::NAStopGiveWaySystem(std::shared_ptr<TrafficLightGroup> priorityTrafficLightGroup, std::shared_ptr<TrafficLightGroup> stopLightGroup)
 {
+    setUpStandardTimings();
+
     setGroups(priorityTrafficLightGroup, stopLightGroup);
+    setUp();
 }
 
-void NAStopGiveWaySystem::run()
+void NAStopGiveWaySystem::start()
 {
-    flash();
+    updateTimings();
+
+    auto flashInterval = getTiming(NAStopGiveWaySystemTimings::FlashInterval);
+    auto loopLength = getTiming(NAStopGiveWaySystemTimings::LoopTime);
+
+    _flashesRemaining = (int)ceil((double)loopLength.count() / (double)(flashInterval.count() * 2));
+
+    _staticYellowSequence->set(flashInterval, (TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing));
+    _staticOffSequenceYellow->set(flashInterval, TrafficLight::Light::RedCrossing);
+    _clearanceSequence->set(getTiming(NAStopGiveWaySystemTimings::ClearanceTime), (TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing));
+
+    _safePointRequested = false;
+    _clearing = false;
+    _stopped = false;
+
+    _flashController->start();
 }
 
-void NAStopGiveWaySystem::setTiming(NAStopGiveWaySystemTimings timing, std::chrono::milliseconds time)
+SystemStep NAStopGiveWaySystem::advance()
 {
-    setTimingInternal(timing, time);
+    std::chrono::milliseconds delay;
+
+    //Traffic on the priority road doesn't stop for a flashing yellow, so it is given a steady yellow before the red.
+    if (_safePointRequested && !_clearing && !_stopped) {
+        _flashesRemaining = 0;
+        _clearing = true;
+        _clearanceController->start();
+    }
+
+    if (_clearing) {
+        if (_clearanceController->advance(delay)) {
+            return SystemStep::delayFor(delay);
+        }
+
+        _clearing = false;
+        _stopped = true;
+    }
+
+    while (_flashesRemaining > 0) {
+        if (_flashController->advance(delay)) {
+            return SystemStep::delayFor(delay);
+        }
+
+        if (--_flashesRemaining > 0) {
+            _flashController->start();
+        }
+    }
+
+    return SystemStep::finished();
+}
+
+bool NAStopGiveWaySystem::setTiming(NAStopGiveWaySystemTimings timing, std::chrono::milliseconds time)
+{
+    return setTimingInternal(timing, time);
+}
+
+bool NAStopGiveWaySystem::isAtSafePoint() const
+{
+    return _stopped;
+}
+
+bool NAStopGiveWaySystem::isHoldingStep() const
+{
+    return !_clearing && !_stopped;
+}
+
+void NAStopGiveWaySystem::requestSafePoint()
+{
+    _safePointRequested = true;
 }
 
 void NAStopGiveWaySystem::setGroups(std::shared_ptr<TrafficLightGroup> priority, std::shared_ptr<TrafficLightGroup> stop)
@@ -51,30 +122,35 @@ void NAStopGiveWaySystem::setGroups(std::shared_ptr<TrafficLightGroup> priority,
     _stopGroup = stop;
 }
 
-void NAStopGiveWaySystem::flash()
-{    
-    auto flashInterval = getTiming(NAStopGiveWaySystemTimings::FlashInterval);
-    auto loopLength = getTiming(NAStopGiveWaySystemTimings::LoopTime);
-    auto flashesPerRun = (int)ceil((double)loopLength.count() / (double)(flashInterval.count() * 2));
-
-    auto flashController = std::make_shared<Controller>();
-    
-    auto staticRedSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
-    auto staticYellowSequence = std::make_shared<StaticSequence>(getTiming(NAStopGiveWaySystemTimings::FlashInterval), (TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing));
-    auto staticOffSequenceRed = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), TrafficLight::Light::RedCrossing);
-    auto staticOffSequenceYellow = std::make_shared<StaticSequence>(getTiming(NAStopGiveWaySystemTimings::FlashInterval), TrafficLight::Light::RedCrossing);
-    
-    flashController->addTrafficLightGroup(_priorityGroup, 0);
-    flashController->addTrafficLightGroup(_stopGroup, 1);
-
-    flashController->addSequence(staticRedSequence, 1);
-    flashController->addSequence(staticYellowSequence, 0);
-    flashController->addSequence(staticOffSequenceRed, 1);
-    flashController->addSequence(staticOffSequenceYellow, 0);
-
-    for (auto flash = flashesPerRun; flash > 0; --flash) {
-        flashController->run();
-    }
+void NAStopGiveWaySystem::setUp()
+{
+    static constexpr auto staticRedSequence = makeStaticSequence(std::chrono::milliseconds(0), (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+    static constexpr auto staticOffSequenceRed = makeStaticSequence(std::chrono::milliseconds(0), TrafficLight::Light::RedCrossing);
+
+    _flashController = std::make_shared<Controller>();
+    _conflicts = std::make_shared<ConflictMatrix>(std::vector<std::shared_ptr<TrafficLightGroup>> { _priorityGroup, _stopGroup });
+    _flashController->setConflictMatrix(_conflicts);
+    _staticYellowSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), (TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing));
+    _staticOffSequenceYellow = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), TrafficLight::Light::RedCrossing);
+    _clearanceSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), (TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing));
+
+    _flashController->addTrafficLightGroup(_priorityGroup, 0);
+    _flashController->addTrafficLightGroup(_stopGroup, 1);
+
+    _flashController->addSequence(staticRedSequence, 1);
+    _flashController->addSequence(_staticYellowSequence, 0);
+    _flashController->addSequence(staticOffSequenceRed, 1);
+    _flashController->addSequence(_staticOffSequenceYellow, 0);
+
+    _clearanceController = std::make_shared<Controller>();
+    _clearanceController->setConflictMatrix(_conflicts);
+
+    _clearanceController->addTrafficLightGroup(_priorityGroup, 0);
+    _clearanceController->addTrafficLightGroup(_stopGroup, 1);
+
+    _clearanceController->addSequence(staticRedSequence, 1);
+    _clearanceController->addSequence(_clearanceSequence, 0);
+    _clearanceController->addSequence(staticRedSequence, 0);
 }
 
 std::chrono::milliseconds NAStopGiveWaySystem::getStandardTiming(NAStopGiveWaySystemTimings timing) const
@@ -84,7 +160,42 @@ std::chrono::milliseconds NAStopGiveWaySystem::getStandardTiming(NAStopGiveWaySy
             return std::chrono::seconds(1);
         case NAStopGiveWaySystemTimings::LoopTime:
             return std::chrono::seconds(10);
+        case NAStopGiveWaySystemTimings::ClearanceTime:
+            return std::chrono::seconds(3);
+        case NAStopGiveWaySystemTimings::Count:
+            break;
+    }
+
+    return std::chrono::milliseconds(0);
+}
+
+std::chrono::milliseconds NAStopGiveWaySystem::getMinimumTiming(NAStopGiveWaySystemTimings timing) const
+{
+    //The yellow before red is a clearance, so must never be skipped.
+    switch (timing) {
+        case NAStopGiveWaySystemTimings::ClearanceTime:
+            return std::chrono::seconds(1);
+        case NAStopGiveWaySystemTimings::FlashInterval:
+        case NAStopGiveWaySystemTimings::LoopTime:
+        case NAStopGiveWaySystemTimings::Count:
+            break;
     }
 
     return std::chrono::milliseconds(0);
+}
+
+const char *NAStopGiveWaySystem::describeTiming(NAStopGiveWaySystemTimings timing) const
+{
+    switch (timing) {
+        case NAStopGiveWaySystemTimings::FlashInterval:
+            return "flash";
+        case NAStopGiveWaySystemTimings::LoopTime:
+            return "loop";
+        case NAStopGiveWaySystemTimings::ClearanceTime:
+            return "clearance";
+        case NAStopGiveWaySystemTimings::Count:
+            break;
+    }
+
+    return "";
 }
\ No newline at end of file
@@ -8,29 +8,56 @@
 
 class TrafficLight;
 class TrafficLightGroup;
+class StaticSequence;
+class Controller;
+class ConflictMatrix;
 
 enum class NAStopGiveWaySystemTimings
 {
     FlashInterval, //The time between flashes
-    LoopTime //The amount of time to flash for until resetting
+    LoopTime, //The amount of time to flash for until resetting
+    ClearanceTime, //How long the priority lights show a steady yellow before red when a safe point is asked for
+    Count //The number of timings, not a timing itself
 };
 
-/// @brief North American style flashing red/yellow lights.
+/// @brief North American style flashing red/yellow lights. Every light flashes, so a safe point is only reached when one
+/// is asked for, by holding the priority lights on yellow and then showing red everywhere.
 class NAStopGiveWaySystem : public AbstractSystem<NAStopGiveWaySystemTimings>
 {
 public:
     NAStopGiveWaySystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights, unsigned int priorityLightId = 0);
     NAStopGiveWaySystem(std::shared_ptr<TrafficLightGroup> priorityTrafficLightGroup, std::shared_ptr<TrafficLightGroup> stopLightGroup);
 
-    void run() override;
-    void setTiming(NAStopGiveWaySystemTimings timing, std::chrono::milliseconds time);
+    void start() override;
+
+    SystemStep advance() override;
+    bool setTiming(NAStopGiveWaySystemTimings timing, std::chrono::milliseconds time);
+
+    bool isAtSafePoint() const override;
+    bool isHoldingStep() const override;
+    void requestSafePoint() override;
 
 private:
+    int _flashesRemaining = 0;
+
+    bool _safePointRequested = false;
+    bool _clearing = false;
+    bool _stopped = false;
+
     std::shared_ptr<TrafficLightGroup> _priorityGroup;
     std::shared_ptr<TrafficLightGroup> _stopGroup;
 
+    std::shared_ptr<Controller> _flashController;
+    std::shared_ptr<Controller> _clearanceController;
+    std::shared_ptr<ConflictMatrix> _conflicts;
+    std::shared_ptr<StaticSequence> _staticYellowSequence;
+    std::shared_ptr<StaticSequence> _staticOffSequenceYellow;
+    std::shared_ptr<StaticSequence> _clearanceSequence;
+
     void setGroups(std::shared_ptr<TrafficLightGroup> priority, std::shared_ptr<TrafficLightGroup> stop);
-    void flash();
+    void setUp();
 
     std::chrono::milliseconds getStandardTiming(NAStopGiveWaySystemTimings timing) const override;
+    std::chrono::milliseconds getMinimumTiming(NAStopGiveWaySystemTimings timing) const override;
+    const char *describeTiming(NAStopGiveWaySystemTimings timing) const override;
 };
\ No newline at end of file
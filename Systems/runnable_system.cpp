@@ -0,0 +1,115 @@
+#include "../Hardware/hardware.h"
+#include "../step_scheduler.h"
+#include "../heartbeat.h"
+
+#include "runnable_system.h"
+
+void RunnableSystem::run()
+{
+    auto waitedForRequest = false;
+    auto startedAt = Hardware::clock().now();
+
+    start();
+
+    while (true) {
+        auto step = advance();
+
+        if (step.type == SystemStep::Type::Finished) {
+            break;
+        }
+
+        if (step.type == SystemStep::Type::AwaitRequest) {
+            Heartbeat::beatIdle();
+            Hardware::clock().waitForEvent();
+            Heartbeat::beat();
+            waitedForRequest = true;
+            continue;
+        }
+
+        if (waitedForRequest) {
+            StepScheduler::resynchronise();
+            waitedForRequest = false;
+        }
+
+        StepScheduler::waitFor(step.delay);
+    }
+
+    recordCycle(Hardware::clock().now() - startedAt);
+    StepScheduler::endCycle();
+}
+
+const DurationHistogram &RunnableSystem::getCycleDurations() const
+{
+    return _cycleDurations;
+}
+
+void RunnableSystem::recordCycle(std::chrono::microseconds duration)
+{
+    _cycleDurations.record(duration);
+}
+
+
+const char *RunnableSystem::getPhaseName(uint8_t phase) const
+{
+    return "running";
+}
+
+SystemStatus RunnableSystem::getStatus() const
+{
+    auto packed = _status.load(std::memory_order_relaxed);
+
+    SystemStatus status;
+    status.phase = (uint8_t)(packed & 0xff);
+    status.group = (int)(packed >> 8) - 1;
+
+    return status;
+}
+
+bool RunnableSystem::isAtSafePoint() const
+{
+    return false;
+}
+
+bool RunnableSystem::isHoldingStep() const
+{
+    return false;
+}
+
+void RunnableSystem::requestSafePoint()
+{
+}
+
+size_t RunnableSystem::getModeCount() const
+{
+    return 0;
+}
+
+size_t RunnableSystem::getTimingCount() const
+{
+    return 0;
+}
+
+const char *RunnableSystem::getTimingName(size_t timing) const
+{
+    return "";
+}
+
+bool RunnableSystem::readTiming(size_t timing, int groupId, std::chrono::milliseconds &time)
+{
+    return false;
+}
+
+bool RunnableSystem::publishTiming(size_t timing, int groupId, std::chrono::milliseconds time)
+{
+    return false;
+}
+
+bool RunnableSystem::getTimingLimits(size_t timing, std::chrono::milliseconds &minimum, std::chrono::milliseconds &maximum) const
+{
+    return false;
+}
+
+void RunnableSystem::setStatus(uint8_t phase, int group)
+{
+    _status.store(phase | ((uint32_t)(group + 1) << 8), std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "../duration_histogram.h"
+
+/// @brief What a system wants to happen after it has been advanced.
+struct SystemStep
+{
+    enum class Type
+    {
+        Delay, //Wait for delay before advancing again.
+        AwaitRequest, //Wait for a request to arrive before advancing again.
+        Finished //The cycle is complete.
+    };
+
+    Type type = Type::Finished;
+    std::chrono::milliseconds delay = std::chrono::milliseconds(0);
+
+    static SystemStep delayFor(std::chrono::milliseconds delay) { return { Type::Delay, delay }; }
+    static SystemStep awaitRequest() { return { Type::AwaitRequest, std::chrono::milliseconds(0) }; }
+    static SystemStep finished() { return { Type::Finished, std::chrono::milliseconds(0) }; }
+};
+
+/// @brief What a system is doing, as last reported by the core running it.
+struct SystemStatus
+{
+    static constexpr int NoGroup = -1;
+
+    uint8_t phase = 0;
+    int group = NoGroup;
+};
+
+/// @brief A system that can either be run to the end of a cycle in one blocking call, or stepped through one timed step
+/// at a time so that several systems can share a core (see CooperativeScheduler).
+class RunnableSystem
+{
+public:
+    virtual ~RunnableSystem() = default;
+
+    /// @brief Runs a full cycle of the system, sleeping between steps.
+    virtual void run();
+
+    /// @brief Starts a new cycle without blocking.
+    virtual void start() = 0;
+
+    /// @brief Carries out the next step of the cycle, which shows lights and returns straight away.
+    virtual SystemStep advance() = 0;
+
+    /// @brief Gets how long every finished cycle took. The number of cycles run is its count.
+    const DurationHistogram &getCycleDurations() const;
+
+    /// @brief Records a finished cycle. Called by run(), and by anything else stepping the system itself.
+    void recordCycle(std::chrono::microseconds duration);
+
+    /// @brief The name of a phase reported in getStatus().
+    virtual const char *getPhaseName(uint8_t phase) const;
+
+    /// @brief Gets the phase and group the system last reported. Safe to call from any core.
+    SystemStatus getStatus() const;
+
+    /// @brief Whether the lights last shown can be handed straight over to another system, which means every vehicle and
+    /// crossing light is on red. A system that doesn't override this is never at one, so a switch waits for the next
+    /// system that is.
+    virtual bool isAtSafePoint() const;
+
+    /// @brief Whether the step last shown only holds a green or a crossing light, rather than taking the lights through a
+    /// yellow or a clearance. An immediate switch cuts these steps short on the way to a safe point, but never a
+    /// clearance.
+    virtual bool isHoldingStep() const;
+
+    /// @brief Asks the system to head for its next safe point rather than wait for a request first, such as by acting as
+    /// if a crossing was requested. Call from the core running the system.
+    virtual void requestSafePoint();
+
+    /// @brief The number of modes a ModeChange request can pick from, numbered from 0. Systems that take no ModeChange
+    /// requests have none.
+    virtual size_t getModeCount() const;
+
+    /// @brief The number of timings the system has. Timings can be read and published by index through this class so
+    /// tools like the console can tune any system.
+    virtual size_t getTimingCount() const;
+
+    virtual const char *getTimingName(size_t timing) const;
+
+    /// @brief Reads a timing from the profile the system last picked up. Only one core or thread other than the one
+    /// running the system may read or publish timings by index.
+    /// @return False if there is no such timing, or the group can't have timings of its own.
+    virtual bool readTiming(size_t timing, int groupId, std::chrono::milliseconds &time);
+
+    /// @brief Publishes the profile the system last picked up with one timing changed, which the system picks up at its
+    /// next phase boundary. Changes published before the system picks them up are kept.
+    /// @return False if there is no such timing, or the time is outside its limits.
+    virtual bool publishTiming(size_t timing, int groupId, std::chrono::milliseconds time);
+
+    /// @brief Gets the shortest and longest a timing can safely be set to, such as a clearance time that must never be 0.
+    /// @return False if there is no such timing.
+    virtual bool getTimingLimits(size_t timing, std::chrono::milliseconds &minimum, std::chrono::milliseconds &maximum) const;
+
+protected:
+    /// @brief Reports what the system is doing. Call from the core running the system.
+    void setStatus(uint8_t phase, int group = SystemStatus::NoGroup);
+
+private:
+    DurationHistogram _cycleDurations;
+
+    //Phase in the low byte and group + 1 above it, so both are read in one load.
+    std::atomic<uint32_t> _status = 0;
+};
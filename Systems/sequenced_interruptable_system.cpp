@@ -1,19 +1,25 @@
+#include <algorithm>
 #include <memory>
 #include <list>
 #include <vector>
 #include <chrono>
 
-#include "pico/stdlib.h"
+#include "../Hardware/hardware.h"
 
 #include "../controller.h"
+#include "../conflict_monitor.h"
 #include "../trafficlight_group.h"
 #include "../sequence.h"
 #include "../common_sequences.h"
+#include "../common_fixed_sequences.h"
+#include "../crossing_button.h"
+#include "../trace_recorder.h"
 
 #include "sequenced_interruptable_system.h"
 
 SequencedInterruptableSystem::SequencedInterruptableSystem()
 {
+    setUpStandardTimings();
 }
 
 SequencedInterruptableSystem::SequencedInterruptableSystem(LightType lightType, CrossingType crossingType, SequenceType sequenceType) : SequencedInterruptableSystem()
@@ -46,11 +52,12 @@ SequencedInterruptableSystem::SequencedInterruptableSystem(std::vector<std::shar
 
 void SequencedInterruptableSystem::requestCrossing()
 {
-    _crossingRequested = true;
+    markCrossingRequested(Hardware::clock().now());
 }
 
 void SequencedInterruptableSystem::requestNextGroup()
 {
+    TraceRecorder::record(TraceRecord::NoGroup, 0, TraceRecord::Cause::NextGroupRequest);
     _nextGroupRequested = true;
 }
 
@@ -69,14 +76,39 @@ void SequencedInterruptableSystem::setSequenceType(SequenceType sequenceType)
     _sequenceType = sequenceType;
 }
 
-void SequencedInterruptableSystem::setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time)
-{    
-    setTimingInternal(timing, time);
+bool SequencedInterruptableSystem::setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time)
+{
+    return setTimingInternal(timing, time);
 }
 
-void SequencedInterruptableSystem::setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time, unsigned int groupId)
+bool SequencedInterruptableSystem::setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time, unsigned int groupId)
 {
-    setTimingInternal(timing, time, groupId);
+    if (groupId >= (unsigned int)MaximumTimingGroups) {
+        return false;
+    }
+
+    return setTimingInternal(timing, time, (int)groupId);
+}
+
+RequestChannel &SequencedInterruptableSystem::getRequestChannel(size_t producer)
+{
+    return _requests[producer < _requests.size() ? producer : 0];
+}
+
+size_t SequencedInterruptableSystem::getModeCount() const
+{
+    return (size_t)SequenceType::Manual + 1;
+}
+
+void SequencedInterruptableSystem::setCrossingButtonPin(uint pin, std::chrono::milliseconds debounceTime)
+{
+    _crossingButton.reset();
+    _crossingButton = std::make_shared<CrossingButton>(pin, _requests[0], debounceTime);
+}
+
+std::chrono::microseconds SequencedInterruptableSystem::getCrossingLatency() const
+{
+    return _crossingLatency;
 }
 
 void SequencedInterruptableSystem::reset()
@@ -84,17 +116,41 @@ void SequencedInterruptableSystem::reset()
     _currentGroup = 0;
 }
 
-void SequencedInterruptableSystem::run()
+void SequencedInterruptableSystem::start()
 {
     reset();
+    updateScheduledTimings();
+    startRedToGreen();
+}
 
-    do {
-        doRedToGreen();
-        awaitNextGroupRequested();
-        doGreenToRed();
-        doCrossingIfRequested();            
+SystemStep SequencedInterruptableSystem::advance()
+{
+    std::chrono::milliseconds delay;
+
+    while (_phase != Phase::Finished) {
+        switch (_phase) {
+            case Phase::RedToGreen:
+            case Phase::GreenToRed:
+            case Phase::Crossing:
+                if (_activeController->advance(delay)) {
+                    return SystemStep::delayFor(delay);
+                }
+
+                finishPhase();
+                break;
+            case Phase::AwaitNextGroup:
+                if (!isNextGroupReady()) {
+                    return SystemStep::awaitRequest();
+                }
+
+                startGreenToRed();
+                break;
+            case Phase::Finished:
+                break;
+        }
     }
-    while (advanceToNextGroup());
+
+    return SystemStep::finished();
 }
 
 void SequencedInterruptableSystem::setGroups(std::vector<std::shared_ptr<TrafficLightGroup>> groups)
@@ -105,6 +161,7 @@ void SequencedInterruptableSystem::setGroups(std::vector<std::shared_ptr<Traffic
 void SequencedInterruptableSystem::setUp()
 {
     setUpAllLightsGroup();
+    setUpControllers();
 }
 
 void SequencedInterruptableSystem::setUpAllLightsGroup()
@@ -120,68 +177,181 @@ void SequencedInterruptableSystem::setUpAllLightsGroup()
     }
 }
 
-void SequencedInterruptableSystem::awaitNextGroupRequested()
+void SequencedInterruptableSystem::setUpControllers()
 {
-    while (_sequenceType == SequenceType::Manual && !_nextGroupRequested) {
-        sleep_ms(100);
+    static constexpr auto greenToRedSequence = makeGreenToRedSequence(std::chrono::milliseconds(0));
+    static constexpr auto greenCrossingToRedCrossingSequence = makeGreenCrossingToRedCrossingSequence(std::chrono::milliseconds(0));
+
+    _redToGreenController = std::make_shared<Controller>();
+    _greenToRedController = std::make_shared<Controller>();
+    _crossingController = std::make_shared<Controller>();
+
+    //The groups take turns, so only one of them may ever be green.
+    _conflicts = std::make_shared<ConflictMatrix>(_groups);
+    _redToGreenController->setConflictMatrix(_conflicts);
+    _greenToRedController->setConflictMatrix(_conflicts);
+    _crossingController->setConflictMatrix(_conflicts);
+
+    _staticRedSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0));
+    _redToGreenSequence = std::make_shared<RedToGreenSequence>(std::chrono::milliseconds(0));
+    _crossingStaticRedSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0));
+    _redCrossingToGreenCrossingSequence = std::make_shared<RedCrossingToGreenCrossingSequence>(std::chrono::milliseconds(0));
+    _crossingStaticOffSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), TrafficLight::Light::Red);
+
+    _redToGreenController->addTrafficLightGroup(_allLightsGroup, 0);
+    _redToGreenController->addTrafficLightGroup(getCurrentGroup(), 1);
+    _redToGreenController->addSequence(_staticRedSequence, 0);
+    _redToGreenController->addSequence(_redToGreenSequence, 1);
+
+    _greenToRedController->addTrafficLightGroup(_allLightsGroup, 0);
+    _greenToRedController->addTrafficLightGroup(getCurrentGroup(), 1);
+    _greenToRedController->addSequence(greenToRedSequence, 1);
+
+    _crossingController->addTrafficLightGroup(_allLightsGroup, 0);
+    _crossingController->addSequence(_crossingStaticRedSequence, 0);
+    _crossingController->addSequence(_redCrossingToGreenCrossingSequence, 0);
+    _crossingController->addSequence(_crossingStaticOffSequence, 0);
+    _crossingController->addSequence(greenCrossingToRedCrossingSequence, 0);
+}
+
+void SequencedInterruptableSystem::processRequests()
+{
+    RequestEvent event;
+
+    for (auto &requests : _requests) {
+        while (requests.receive(event)) {
+            switch (event.type) {
+                case RequestEvent::Type::Crossing:
+                    markCrossingRequested(event.timestamp);
+                    break;
+                case RequestEvent::Type::NextGroup:
+                    TraceRecorder::record(TraceRecord::NoGroup, 0, TraceRecord::Cause::NextGroupRequest);
+                    _nextGroupRequested = true;
+                    break;
+                case RequestEvent::Type::ModeChange:
+                    if (event.value > (uint32_t)SequenceType::Manual) {
+                        TraceRecorder::record(TraceRecord::NoGroup, (uint8_t)std::min<uint32_t>(event.value, 0xff), TraceRecord::Cause::ModeRejected);
+                        break;
+                    }
+
+                    TraceRecorder::record(TraceRecord::NoGroup, (uint8_t)event.value, TraceRecord::Cause::ModeChange);
+                    setSequenceType((SequenceType)event.value);
+                    break;
+            }
+        }
     }
+}
 
-    sleep_ms(100);
-    
-    _nextGroupRequested = false;
+void SequencedInterruptableSystem::markCrossingRequested(std::chrono::microseconds requestedAt)
+{
+    TraceRecorder::record(TraceRecord::NoGroup, 0, TraceRecord::Cause::CrossingRequest);
+
+    if (!_crossingRequested) {
+        _crossingRequested = true;
+        _crossingRequestedAt = requestedAt;
+    }
 }
 
-void SequencedInterruptableSystem::doRedToGreen()
+bool SequencedInterruptableSystem::isNextGroupReady()
 {
-    auto group = getCurrentGroup();
-    auto redToGreenController = std::make_shared<Controller>();
-    auto staticRedSequence = std::make_shared<StaticSequence>(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::DelayUntilGreenLight));
-    auto redToGreenSequence = std::make_shared<RedToGreenSequence>(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight), _lightType == LightType::Red_Green ? RedToGreenSequence::SequenceType::Red_Green : RedToGreenSequence::SequenceType::Red_Yellow_Green);
+    processRequests();
+
+    if (_sequenceType == SequenceType::Manual && !_nextGroupRequested) {
+        return false;
+    }
 
-    redToGreenController->addTrafficLightGroup(_allLightsGroup, 0);
-    redToGreenController->addTrafficLightGroup(group, 1);
-    redToGreenController->addSequence(staticRedSequence, 0);
-    redToGreenController->addSequence(redToGreenSequence, 1);
+    _nextGroupRequested = false;
 
-    redToGreenController->run();
+    return true;
 }
 
-void SequencedInterruptableSystem::doGreenToRed()
+void SequencedInterruptableSystem::startRedToGreen()
 {
-    auto group = getCurrentGroup();
-    auto greenToRedController = std::make_shared<Controller>();
-    auto greenToRedSequence = std::make_shared<GreenToRedSequence>(std::chrono::milliseconds(0));
+    updateTimings();
+
+    _staticRedSequence->set(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::DelayUntilGreenLight));
+    _redToGreenSequence->set(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight), _lightType == LightType::Red_Green ? RedToGreenSequence::SequenceType::Red_Green : RedToGreenSequence::SequenceType::Red_Yellow_Green);
 
-    greenToRedController->addTrafficLightGroup(_allLightsGroup, 0);
-    greenToRedController->addTrafficLightGroup(group, 1);
-    greenToRedController->addSequence(greenToRedSequence, 1);
+    _redToGreenController->addTrafficLightGroup(getCurrentGroup(), 1);
+    startPhase(Phase::RedToGreen, _redToGreenController);
+}
 
-    greenToRedController->run();
+void SequencedInterruptableSystem::startGreenToRed()
+{
+    _greenToRedController->addTrafficLightGroup(getCurrentGroup(), 1);
+    startPhase(Phase::GreenToRed, _greenToRedController);
 }
 
-void SequencedInterruptableSystem::doCrossingIfRequested()
+void SequencedInterruptableSystem::startCrossingIfRequested()
 {
+    processRequests();
+
     if (_crossingRequested && _crossingType != CrossingType::None) {
-        auto crossingController = std::make_shared<Controller>();
-        auto staticRedSequence = std::make_shared<StaticSequence>(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::DelayUntilGreenCrossing));
-        auto redCrossingToGreenCrossingSequence = std::make_shared<RedCrossingToGreenCrossingSequence>(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::CrossingTime));
-        auto staticOffSequence = std::make_shared<StaticSequence>(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::OffTimeBetweenGreenAndRedCrossing), TrafficLight::Light::Red);
-        auto greenCrossingToRedCrossingSequence = std::make_shared<GreenCrossingToRedCrossingSequence>(std::chrono::milliseconds(0));
-
-        crossingController->addTrafficLightGroup(_allLightsGroup, 0);
-        crossingController->addSequence(staticRedSequence, 0);
-        crossingController->addSequence(redCrossingToGreenCrossingSequence, 0);
-        crossingController->addSequence(staticOffSequence, 0);
-        crossingController->addSequence(greenCrossingToRedCrossingSequence, 0);
+        updateTimings();
+
+        _crossingStaticRedSequence->set(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::DelayUntilGreenCrossing));
+        _redCrossingToGreenCrossingSequence->set(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::CrossingTime));
+        _crossingStaticOffSequence->set(getTimingForCurrentGroup(SequencedInterruptableSystemTimings::OffTimeBetweenGreenAndRedCrossing), TrafficLight::Light::Red);
 
         _crossingRequested = false;
-        crossingController->run();
+        _crossingLatency = Hardware::clock().now() - _crossingRequestedAt;
+        startPhase(Phase::Crossing, _crossingController);
+    }
+    else {
+        startNextGroup();
+    }
+}
+
+void SequencedInterruptableSystem::startNextGroup()
+{
+    if (advanceToNextGroup()) {
+        startRedToGreen();
+    }
+    else {
+        startPhase(Phase::Finished, nullptr);
+    }
+}
+
+void SequencedInterruptableSystem::startPhase(Phase phase, std::shared_ptr<Controller> controller)
+{
+    auto now = Hardware::clock().now();
+    if (_phase != Phase::Finished) {
+        _phaseDurations[(size_t)_phase].record(now - _phaseStartedAt);
+    }
+
+    _phase = phase;
+    _phaseStartedAt = now;
+    _activeController = controller;
+
+    setStatus((uint8_t)phase, phase == Phase::Finished ? SystemStatus::NoGroup : _currentGroup);
+
+    if (_activeController) {
+        _shownController = _activeController;
+        _activeController->start();
+    }
+}
+
+void SequencedInterruptableSystem::finishPhase()
+{
+    switch (_phase) {
+        case Phase::RedToGreen:
+            startPhase(Phase::AwaitNextGroup, nullptr);
+            break;
+        case Phase::GreenToRed:
+            startCrossingIfRequested();
+            break;
+        case Phase::Crossing:
+            startNextGroup();
+            break;
+        case Phase::AwaitNextGroup:
+        case Phase::Finished:
+            break;
     }
 }
 
 bool SequencedInterruptableSystem::advanceToNextGroup()
 {
-    if (++_currentGroup < _groups.size()) {
+    if (++_currentGroup < (int)_groups.size()) {
         return true;
     }
 
@@ -205,12 +375,97 @@ std::chrono::milliseconds SequencedInterruptableSystem::getStandardTiming(Sequen
             return std::chrono::seconds(10);
         case SequencedInterruptableSystemTimings::OffTimeBetweenGreenAndRedCrossing:
             return std::chrono::seconds(4);
+        case SequencedInterruptableSystemTimings::Count:
+            break;
     }
 
     return std::chrono::milliseconds(0);
 }
 
+std::chrono::milliseconds SequencedInterruptableSystem::getMinimumTiming(SequencedInterruptableSystemTimings timing) const
+{
+    //Clearance, green and crossing times must never be skipped.
+    switch (timing) {
+        case SequencedInterruptableSystemTimings::DelayUntilGreenLight:
+        case SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight:
+        case SequencedInterruptableSystemTimings::DelayUntilGreenCrossing:
+        case SequencedInterruptableSystemTimings::CrossingTime:
+            return std::chrono::seconds(1);
+        case SequencedInterruptableSystemTimings::OffTimeBetweenGreenAndRedCrossing:
+        case SequencedInterruptableSystemTimings::Count:
+            break;
+    }
+
+    return std::chrono::milliseconds(0);
+}
+
+const char *SequencedInterruptableSystem::describeTiming(SequencedInterruptableSystemTimings timing) const
+{
+    switch (timing) {
+        case SequencedInterruptableSystemTimings::DelayUntilGreenLight:
+            return "green-delay";
+        case SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight:
+            return "min-green";
+        case SequencedInterruptableSystemTimings::DelayUntilGreenCrossing:
+            return "crossing-delay";
+        case SequencedInterruptableSystemTimings::CrossingTime:
+            return "crossing";
+        case SequencedInterruptableSystemTimings::OffTimeBetweenGreenAndRedCrossing:
+            return "crossing-off";
+        case SequencedInterruptableSystemTimings::Count:
+            break;
+    }
+
+    return "";
+}
+
 std::shared_ptr<TrafficLightGroup> SequencedInterruptableSystem::getCurrentGroup() const
 {
     return _groups[_currentGroup];
+}
+
+const DurationHistogram &SequencedInterruptableSystem::getPhaseDurations(Phase phase) const
+{
+    static const DurationHistogram empty;
+
+    return phase != Phase::Finished ? _phaseDurations[(size_t)phase] : empty;
+}
+
+const char *SequencedInterruptableSystem::getPhaseName(uint8_t phase) const
+{
+    switch ((Phase)phase) {
+        case Phase::RedToGreen:
+            return "red-to-green";
+        case Phase::AwaitNextGroup:
+            return "await-next-group";
+        case Phase::GreenToRed:
+            return "green-to-red";
+        case Phase::Crossing:
+            return "crossing";
+        case Phase::Finished:
+            return "finished";
+    }
+
+    return "";
+}
+
+bool SequencedInterruptableSystem::isAtSafePoint() const
+{
+    //Only one group changes at a time while the rest stay on red, so the step last shown says whether every light is red.
+    return _shownController && _shownController->getShownLights() == (TrafficLight::Light::Red | TrafficLight::Light::RedCrossing);
+}
+
+bool SequencedInterruptableSystem::isHoldingStep() const
+{
+    if (!_shownController) {
+        return false;
+    }
+
+    auto lights = _shownController->getShownLights();
+    return (lights & (TrafficLight::Light::Green | TrafficLight::Light::GreenCrossing)) != 0 && (lights & TrafficLight::Light::Yellow) == 0;
+}
+
+void SequencedInterruptableSystem::requestSafePoint()
+{
+    requestNextGroup();
 }
\ No newline at end of file
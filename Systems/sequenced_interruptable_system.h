@@ -1,15 +1,24 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <list>
 #include <vector>
 #include <map>
 
 #include "abstract_system.h"
+#include "../request_channel.h"
+#include "../Hardware/hardware_types.h"
 
 class TrafficLight;
 class TrafficLightGroup;
+class CrossingButton;
 class Sequence;
+class StaticSequence;
+class RedToGreenSequence;
+class RedCrossingToGreenCrossingSequence;
+class Controller;
+class ConflictMatrix;
 
 enum class SequencedInterruptableSystemTimings
 {
@@ -18,6 +27,7 @@ enum class SequencedInterruptableSystemTimings
     DelayUntilGreenCrossing, //Time to wait between red vehicle light and green crossing light.
     CrossingTime, //Allocated time to allow for crossing.
     OffTimeBetweenGreenAndRedCrossing, //Time where both red and green crossing lights are off before switching back to red.
+    Count //The number of timings, not a timing itself
 };
 
 /// @brief A simple system that can take n number of traffic lights or groups and sequence them one after another
@@ -25,6 +35,8 @@ enum class SequencedInterruptableSystemTimings
 class SequencedInterruptableSystem : public AbstractSystem<SequencedInterruptableSystemTimings>
 {
 public:
+    enum class Phase { RedToGreen, AwaitNextGroup, GreenToRed, Crossing, Finished };
+
     enum class LightType { Red_Yellow_Green, Red_Green };
     enum class CrossingType { None, Standard };
     enum class SequenceType { Auto, Manual };
@@ -47,20 +59,72 @@ public:
     /// @param crossingType The type of crossing present.
     SequencedInterruptableSystem(std::vector<std::shared_ptr<TrafficLightGroup>> trafficLightGroups, SequenceType sequenceType = SequenceType::Auto, LightType lightType = LightType::Red_Yellow_Green, CrossingType crossingType = CrossingType::Standard);
 
+    /// @brief Requests a crossing from the core running the system. Requests from another core must be posted to
+    /// getRequestChannel() instead.
     void requestCrossing();
+
+    /// @brief Requests the next group from the core running the system. Requests from another core must be posted to
+    /// getRequestChannel() instead.
     void requestNextGroup();
     void setLightType(LightType lightType);
     void setCrossingType(CrossingType crossingType);
     void setSequenceType(SequenceType sequenceType);
-    void setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time);
-    void setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time, unsigned int groupId);
+    bool setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time);
+
+    /// @brief Sets a timing for one group only.
+    /// @return False if groupId is MaximumTimingGroups or more, as only that many groups can have their own timings.
+    bool setTiming(SequencedInterruptableSystemTimings timing, std::chrono::milliseconds time, unsigned int groupId);
+
     void reset();
-    void run() override;
+    void start() override;
+
+    SystemStep advance() override;
+
+    /// @brief Gets the channel used to send requests from another core. Crossing and NextGroup events map to
+    /// requestCrossing() and requestNextGroup(), and ModeChange events carry the SequenceType to switch to.
+    /// @param producer The channel to use, one for each producer, below RequestChannel::ProducerCount.
+    RequestChannel &getRequestChannel(size_t producer = 0);
+
+    size_t getModeCount() const override;
+
+    /// @brief Sets up a crossing button on the given input pin. Presses are picked up by interrupt and posted to
+    /// getRequestChannel(0), so nothing else should post to that channel once a button is set.
+    /// @param pin The input pin the button is wired to, reading high when pressed.
+    /// @param debounceTime Edges within this time of an accepted press are ignored as bounce.
+    void setCrossingButtonPin(uint pin, std::chrono::milliseconds debounceTime = std::chrono::milliseconds(50));
+
+    /// @brief Gets the time between the last serviced crossing being requested and the crossing starting.
+    std::chrono::microseconds getCrossingLatency() const;
+
+    /// @brief Gets how long each time the system spent in the given phase took, including any time waiting for a request.
+    const DurationHistogram &getPhaseDurations(Phase phase) const;
+
+    const char *getPhaseName(uint8_t phase) const override;
+
+    bool isAtSafePoint() const override;
+    bool isHoldingStep() const override;
+    void requestSafePoint() override;
 
 private:
+    Phase _phase = Phase::Finished;
+    std::chrono::microseconds _phaseStartedAt = std::chrono::microseconds(0);
+    std::array<DurationHistogram, (size_t)Phase::Finished> _phaseDurations;
+
+    std::shared_ptr<Controller> _activeController;
+
+    //The controller whose lights are showing, kept while awaiting a request and after finishing.
+    std::shared_ptr<Controller> _shownController;
+
     bool _nextGroupRequested = false;
     bool _crossingRequested = false;
 
+    std::chrono::microseconds _crossingRequestedAt = std::chrono::microseconds(0);
+    std::chrono::microseconds _crossingLatency = std::chrono::microseconds(0);
+
+    std::array<RequestChannel, RequestChannel::ProducerCount> _requests;
+
+    std::shared_ptr<CrossingButton> _crossingButton;
+
     int _currentGroup = 0;
 
     LightType _lightType = LightType::Red_Yellow_Green;
@@ -70,21 +134,40 @@ private:
     std::shared_ptr<TrafficLightGroup> _allLightsGroup;
     std::vector<std::shared_ptr<TrafficLightGroup>> _groups;
 
+    std::shared_ptr<Controller> _redToGreenController;
+    std::shared_ptr<Controller> _greenToRedController;
+    std::shared_ptr<Controller> _crossingController;
+
+    std::shared_ptr<ConflictMatrix> _conflicts;
+    std::shared_ptr<StaticSequence> _staticRedSequence;
+    std::shared_ptr<RedToGreenSequence> _redToGreenSequence;
+    std::shared_ptr<StaticSequence> _crossingStaticRedSequence;
+    std::shared_ptr<RedCrossingToGreenCrossingSequence> _redCrossingToGreenCrossingSequence;
+    std::shared_ptr<StaticSequence> _crossingStaticOffSequence;
+
     SequencedInterruptableSystem();
     SequencedInterruptableSystem(LightType lightType, CrossingType crossingType, SequenceType sequenceType);
 
     void setGroups(std::vector<std::shared_ptr<TrafficLightGroup>> groups);
     void setUp();
     void setUpAllLightsGroup();
-    void awaitNextGroupRequested();
-    void doRedToGreen();
-    void doGreenToRed();
-    void doCrossingIfRequested();
-
+    void setUpControllers();
+    void processRequests();
+    void markCrossingRequested(std::chrono::microseconds requestedAt);
+    void startRedToGreen();
+    void startGreenToRed();
+    void startCrossingIfRequested();
+    void startNextGroup();
+    void startPhase(Phase phase, std::shared_ptr<Controller> controller);
+    void finishPhase();
+
+    bool isNextGroupReady();
     bool advanceToNextGroup();
 
     std::chrono::milliseconds getTimingForCurrentGroup(SequencedInterruptableSystemTimings timing) const;
     std::chrono::milliseconds getStandardTiming(SequencedInterruptableSystemTimings timing) const override;
+    std::chrono::milliseconds getMinimumTiming(SequencedInterruptableSystemTimings timing) const override;
+    const char *describeTiming(SequencedInterruptableSystemTimings timing) const override;
 
     std::shared_ptr<TrafficLightGroup> getCurrentGroup() const;
 };
\ No newline at end of file
@@ -1,17 +1,24 @@
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 
-#include "pico/stdlib.h"
+#include "../Hardware/hardware.h"
 
 #include "../trafficlight.h"
 #include "../trafficlight_group.h"
 #include "../controller.h"
+#include "../conflict_monitor.h"
 #include "../common_sequences.h"
+#include "../common_fixed_sequences.h"
+#include "../crossing_button.h"
+#include "../trace_recorder.h"
 
 #include "single_interruptable_crossing_system.h"
 
 SingleInterruptableCrossingSystem::SingleInterruptableCrossingSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights, CrossingStyle crossingStyle, LightType lightType)
 {
+    setUpStandardTimings();
+
     setTrafficLights(trafficLights);
     setCrossingStyle(crossingStyle);
     setLightType(lightType);
@@ -20,6 +27,8 @@ SingleInterruptableCrossingSystem::SingleInterruptableCrossingSystem(std::vector
 
 SingleInterruptableCrossingSystem::SingleInterruptableCrossingSystem(std::shared_ptr<TrafficLightGroup> group, CrossingStyle crossingStyle, LightType lightType)
 {
+    setUpStandardTimings();
+
     setTrafficLights(group->getTrafficLights());
     setCrossingStyle(crossingStyle);
     setLightType(lightType);
@@ -28,7 +37,7 @@ SingleInterruptableCrossingSystem::SingleInterruptableCrossingSystem(std::shared
 
 void SingleInterruptableCrossingSystem::requestCrossing()
 {
-    _crossingRequested = true;
+    markCrossingRequested(Hardware::clock().now());
 }
 
 void SingleInterruptableCrossingSystem::setCrossingStyle(CrossingStyle crossingStyle)
@@ -41,9 +50,30 @@ void SingleInterruptableCrossingSystem::setLightType(LightType lightType)
     _lightType = lightType;
 }
 
-void SingleInterruptableCrossingSystem::setTiming(SingleInterruptableCrossingSystemTimings timing, std::chrono::milliseconds time)
+bool SingleInterruptableCrossingSystem::setTiming(SingleInterruptableCrossingSystemTimings timing, std::chrono::milliseconds time)
+{
+    return setTimingInternal(timing, time);
+}
+
+RequestChannel &SingleInterruptableCrossingSystem::getRequestChannel(size_t producer)
+{
+    return _requests[producer < _requests.size() ? producer : 0];
+}
+
+size_t SingleInterruptableCrossingSystem::getModeCount() const
+{
+    return (size_t)CrossingStyle::Flashing + 1;
+}
+
+void SingleInterruptableCrossingSystem::setCrossingButtonPin(uint pin, std::chrono::milliseconds debounceTime)
+{
+    _crossingButton.reset();
+    _crossingButton = std::make_shared<CrossingButton>(pin, _requests[0], debounceTime);
+}
+
+std::chrono::microseconds SingleInterruptableCrossingSystem::getCrossingLatency() const
 {
-    setTimingInternal(timing, time);
+    return _crossingLatency;
 }
 
 void SingleInterruptableCrossingSystem::reset()
@@ -51,12 +81,41 @@ void SingleInterruptableCrossingSystem::reset()
     
 }
 
-void SingleInterruptableCrossingSystem::run()
+void SingleInterruptableCrossingSystem::start()
 {
-    doGreen();
-    awaitCrossingRequest();
-    doGreenToRed();
-    doCrossing();
+    _safePointRequested = false;
+    updateScheduledTimings();
+    startPhase(Phase::Green, _staticGreenController);
+}
+
+SystemStep SingleInterruptableCrossingSystem::advance()
+{
+    std::chrono::milliseconds delay;
+
+    while (_phase != Phase::Finished) {
+        switch (_phase) {
+            case Phase::Green:
+            case Phase::GreenToRed:
+            case Phase::Crossing:
+                if (_activeController->advance(delay)) {
+                    return SystemStep::delayFor(delay);
+                }
+
+                finishPhase();
+                break;
+            case Phase::AwaitCrossing:
+                if (!isCrossingRequested()) {
+                    return SystemStep::awaitRequest();
+                }
+
+                startGreenToRed();
+                break;
+            case Phase::Finished:
+                break;
+        }
+    }
+
+    return SystemStep::finished();
 }
 
 void SingleInterruptableCrossingSystem::setTrafficLights(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
@@ -66,66 +125,163 @@ void SingleInterruptableCrossingSystem::setTrafficLights(std::vector<std::shared
 
 void SingleInterruptableCrossingSystem::setUp()
 {
-    
-}
+    static constexpr auto staticGreenSequence = makeStaticSequence(std::chrono::seconds(0), (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing));
 
-void SingleInterruptableCrossingSystem::doGreen()
-{
-    auto staticGreenController = std::make_shared<Controller>();
-    auto staticGreenSequence = std::make_shared<StaticSequence>(std::chrono::seconds(0), (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing));
+    _staticGreenController = std::make_shared<Controller>();
+    _greenToRedController = std::make_shared<Controller>();
+    _standardCrossingController = std::make_shared<Controller>();
+    _flashingCrossingController = std::make_shared<Controller>();
+
+    _conflicts = std::make_shared<ConflictMatrix>(std::vector<std::shared_ptr<TrafficLightGroup>> { _lightsGroup });
+    _staticGreenController->setConflictMatrix(_conflicts);
+    _greenToRedController->setConflictMatrix(_conflicts);
+    _standardCrossingController->setConflictMatrix(_conflicts);
+    _flashingCrossingController->setConflictMatrix(_conflicts);
+
+    _staticGreenSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing));
+    _greenToRedSequence = std::make_shared<GreenToRedSequence>(std::chrono::milliseconds(0));
+    _redCrossingToGreenCrossingSequence = std::make_shared<RedCrossingToGreenCrossingSequence>(std::chrono::milliseconds(0));
+    _staticOffSequence = std::make_shared<StaticSequence>(std::chrono::milliseconds(0), TrafficLight::Light::Red);
+    _greenCrossingToRedCrossingSequence = std::make_shared<GreenCrossingToRedCrossingSequence>(std::chrono::milliseconds(0));
+    _redToGreenSequence = std::make_shared<RedToGreenSequence>(std::chrono::milliseconds(0));
+    _greenCrossingFlash = std::make_shared<FlashingCrossingToGreenSequence>(std::chrono::milliseconds(0));
 
-    staticGreenController->addTrafficLightGroup(_lightsGroup, 0);
-    staticGreenController->addSequence(staticGreenSequence, 0);
+    _staticGreenController->addTrafficLightGroup(_lightsGroup, 0);
+    _staticGreenController->addSequence(staticGreenSequence, 0);
 
-    staticGreenController->run();
+    _greenToRedController->addTrafficLightGroup(_lightsGroup, 0);
+    _greenToRedController->addSequence(_staticGreenSequence, 0);
+    _greenToRedController->addSequence(_greenToRedSequence, 0);
+
+    _standardCrossingController->addTrafficLightGroup(_lightsGroup, 0);
+    _standardCrossingController->addSequence(_redCrossingToGreenCrossingSequence, 0);
+    _standardCrossingController->addSequence(_staticOffSequence, 0);
+    _standardCrossingController->addSequence(_greenCrossingToRedCrossingSequence, 0);
+    _standardCrossingController->addSequence(_redToGreenSequence, 0);
+
+    _flashingCrossingController->addTrafficLightGroup(_lightsGroup, 0);
+    _flashingCrossingController->addSequence(_redCrossingToGreenCrossingSequence, 0);
+    _flashingCrossingController->addSequence(_greenCrossingFlash, 0);
 }
 
-void SingleInterruptableCrossingSystem::doGreenToRed()
+void SingleInterruptableCrossingSystem::startGreenToRed()
 {
-    auto greenToRedController = std::make_shared<Controller>();
-    auto staticGreenSequence = std::make_shared<StaticSequence>(getTiming(SingleInterruptableCrossingSystemTimings::DelayAfterCrossingRequest), (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing));
-    auto greenToRedSequence = std::make_shared<GreenToRedSequence>(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenRedLightAndGreenCrossing));
+    updateTimings();
+    _safePointRequested = false;
 
-    greenToRedController->addTrafficLightGroup(_lightsGroup, 0);
-    greenToRedController->addSequence(staticGreenSequence, 0);
-    greenToRedController->addSequence(greenToRedSequence, 0);
+    _staticGreenSequence->set(getTiming(SingleInterruptableCrossingSystemTimings::DelayAfterCrossingRequest), (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing));
+    _greenToRedSequence->set(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenRedLightAndGreenCrossing));
 
-    greenToRedController->run();
+    startPhase(Phase::GreenToRed, _greenToRedController);
 }
 
-void SingleInterruptableCrossingSystem::doCrossing()
+void SingleInterruptableCrossingSystem::startCrossing()
 {
+    updateTimings();
+
     auto crossingTime = getTiming(SingleInterruptableCrossingSystemTimings::CrossingTime);
     auto flashTime = getTiming(SingleInterruptableCrossingSystemTimings::FlashInterval);
     auto numberOfFlashes = (int)ceil((double)crossingTime.count() / (double)(flashTime.count() * 2));
 
-    auto crossingController = std::make_shared<Controller>();
-    auto redCrossingToGreenCrossingSequence = std::make_shared<RedCrossingToGreenCrossingSequence>(getTiming(SingleInterruptableCrossingSystemTimings::CrossingTime));
-    auto staticOffSequence = std::make_shared<StaticSequence>(getTiming(SingleInterruptableCrossingSystemTimings::OffTimeBetweenGreenAndRedCrossing), TrafficLight::Light::Red);
-    auto greenCrossingToRedCrossingSequence = std::make_shared<GreenCrossingToRedCrossingSequence>(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenRedCrossingAndGreenLight));
-    auto greenCrossingFlash = std::make_shared<FlashingCrossingToGreenSequence>(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests), numberOfFlashes, getTiming(SingleInterruptableCrossingSystemTimings::FlashInterval));
-    auto redToGreenSequence = std::make_shared<RedToGreenSequence>(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests), _lightType == LightType::Red_Green ? RedToGreenSequence::SequenceType::Red_Green : RedToGreenSequence::SequenceType::Red_Yellow_Green);
+    _redCrossingToGreenCrossingSequence->set(crossingTime);
+    _staticOffSequence->set(getTiming(SingleInterruptableCrossingSystemTimings::OffTimeBetweenGreenAndRedCrossing), TrafficLight::Light::Red);
+    _greenCrossingToRedCrossingSequence->set(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenRedCrossingAndGreenLight));
+    _greenCrossingFlash->set(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests), numberOfFlashes, flashTime);
+    _redToGreenSequence->set(getTiming(SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests), _lightType == LightType::Red_Green ? RedToGreenSequence::SequenceType::Red_Green : RedToGreenSequence::SequenceType::Red_Yellow_Green);
 
-    crossingController->addTrafficLightGroup(_lightsGroup, 0);
-    crossingController->addSequence(redCrossingToGreenCrossingSequence, 0);
-    
-    if (_crossingStyle == CrossingStyle::Standard) {
-        crossingController->addSequence(staticOffSequence, 0);
-        crossingController->addSequence(greenCrossingToRedCrossingSequence, 0);
-        crossingController->addSequence(redToGreenSequence, 0);
+    _crossingRequested = false;
+
+    startPhase(Phase::Crossing, _crossingStyle == CrossingStyle::Standard ? _standardCrossingController : _flashingCrossingController);
+}
+
+void SingleInterruptableCrossingSystem::startPhase(Phase phase, std::shared_ptr<Controller> controller)
+{
+    auto now = Hardware::clock().now();
+    if (_phase != Phase::Finished) {
+        _phaseDurations[(size_t)_phase].record(now - _phaseStartedAt);
+    }
+
+    _phase = phase;
+    _phaseStartedAt = now;
+    _activeController = controller;
+
+    setStatus((uint8_t)phase);
+
+    if (_activeController) {
+        _shownController = _activeController;
+        _activeController->start();
     }
-    else {
-        crossingController->addSequence(greenCrossingFlash, 0);
+}
+
+void SingleInterruptableCrossingSystem::finishPhase()
+{
+    switch (_phase) {
+        case Phase::Green:
+            startPhase(Phase::AwaitCrossing, nullptr);
+            break;
+        case Phase::GreenToRed:
+            startCrossing();
+            break;
+        case Phase::Crossing:
+            if (_safePointRequested) {
+                startGreenToRed();
+                break;
+            }
+
+            startPhase(Phase::Finished, nullptr);
+            break;
+        case Phase::AwaitCrossing:
+        case Phase::Finished:
+            break;
     }
+}
 
-    _crossingRequested = false;
-    crossingController->run();
+bool SingleInterruptableCrossingSystem::isCrossingRequested()
+{
+    processRequests();
+
+    if (!_crossingRequested) {
+        return false;
+    }
+
+    _crossingLatency = Hardware::clock().now() - _crossingRequestedAt;
+
+    return true;
 }
 
-void SingleInterruptableCrossingSystem::awaitCrossingRequest()
+void SingleInterruptableCrossingSystem::processRequests()
 {
-    while (!_crossingRequested) {
-        sleep_ms(100);
+    RequestEvent event;
+
+    for (auto &requests : _requests) {
+        while (requests.receive(event)) {
+            switch (event.type) {
+                case RequestEvent::Type::Crossing:
+                    markCrossingRequested(event.timestamp);
+                    break;
+                case RequestEvent::Type::ModeChange:
+                    if (event.value > (uint32_t)CrossingStyle::Flashing) {
+                        TraceRecorder::record(TraceRecord::NoGroup, (uint8_t)std::min<uint32_t>(event.value, 0xff), TraceRecord::Cause::ModeRejected);
+                        break;
+                    }
+
+                    TraceRecorder::record(TraceRecord::NoGroup, (uint8_t)event.value, TraceRecord::Cause::ModeChange);
+                    setCrossingStyle((CrossingStyle)event.value);
+                    break;
+                case RequestEvent::Type::NextGroup:
+                    break;
+            }
+        }
+    }
+}
+
+void SingleInterruptableCrossingSystem::markCrossingRequested(std::chrono::microseconds requestedAt)
+{
+    TraceRecorder::record(TraceRecord::NoGroup, 0, TraceRecord::Cause::CrossingRequest);
+
+    if (!_crossingRequested) {
+        _crossingRequested = true;
+        _crossingRequestedAt = requestedAt;
     }
 }
 
@@ -146,7 +302,102 @@ std::chrono::milliseconds SingleInterruptableCrossingSystem::getStandardTiming(S
             return std::chrono::seconds(3);
         case SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests:
             return std::chrono::seconds(5);
+        case SingleInterruptableCrossingSystemTimings::Count:
+            break;
+    }
+
+    return std::chrono::milliseconds(0);
+}
+
+std::chrono::milliseconds SingleInterruptableCrossingSystem::getMinimumTiming(SingleInterruptableCrossingSystemTimings timing) const
+{
+    //Clearance and crossing times must never be skipped, and a flash needs long enough to be seen.
+    switch (timing) {
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenRedLightAndGreenCrossing:
+        case SingleInterruptableCrossingSystemTimings::CrossingTime:
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenRedCrossingAndGreenLight:
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests:
+            return std::chrono::seconds(1);
+        case SingleInterruptableCrossingSystemTimings::FlashInterval:
+            return std::chrono::milliseconds(100);
+        case SingleInterruptableCrossingSystemTimings::DelayAfterCrossingRequest:
+        case SingleInterruptableCrossingSystemTimings::OffTimeBetweenGreenAndRedCrossing:
+        case SingleInterruptableCrossingSystemTimings::Count:
+            break;
     }
 
     return std::chrono::milliseconds(0);
 }
+
+const char *SingleInterruptableCrossingSystem::describeTiming(SingleInterruptableCrossingSystemTimings timing) const
+{
+    switch (timing) {
+        case SingleInterruptableCrossingSystemTimings::DelayAfterCrossingRequest:
+            return "request-delay";
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenRedLightAndGreenCrossing:
+            return "crossing-delay";
+        case SingleInterruptableCrossingSystemTimings::CrossingTime:
+            return "crossing";
+        case SingleInterruptableCrossingSystemTimings::FlashInterval:
+            return "flash";
+        case SingleInterruptableCrossingSystemTimings::OffTimeBetweenGreenAndRedCrossing:
+            return "crossing-off";
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenRedCrossingAndGreenLight:
+            return "green-delay";
+        case SingleInterruptableCrossingSystemTimings::DelayBetweenCrossingRequests:
+            return "request-gap";
+        case SingleInterruptableCrossingSystemTimings::Count:
+            break;
+    }
+
+    return "";
+}
+
+const DurationHistogram &SingleInterruptableCrossingSystem::getPhaseDurations(Phase phase) const
+{
+    static const DurationHistogram empty;
+
+    return phase != Phase::Finished ? _phaseDurations[(size_t)phase] : empty;
+}
+
+const char *SingleInterruptableCrossingSystem::getPhaseName(uint8_t phase) const
+{
+    switch ((Phase)phase) {
+        case Phase::Green:
+            return "green";
+        case Phase::AwaitCrossing:
+            return "await-crossing";
+        case Phase::GreenToRed:
+            return "green-to-red";
+        case Phase::Crossing:
+            return "crossing";
+        case Phase::Finished:
+            return "finished";
+    }
+
+    return "";
+}
+
+bool SingleInterruptableCrossingSystem::isAtSafePoint() const
+{
+    //Every light is red at the end of green to red, and between the crossing lights going red and the vehicle lights
+    //changing back in a standard crossing. A flashing crossing never shows red to both, so a safe point asked for part
+    //way through one is reached by going back through green to red.
+    return _shownController && _shownController->getShownLights() == (TrafficLight::Light::Red | TrafficLight::Light::RedCrossing);
+}
+
+bool SingleInterruptableCrossingSystem::isHoldingStep() const
+{
+    if (!_shownController) {
+        return false;
+    }
+
+    auto lights = _shownController->getShownLights();
+    return (lights & (TrafficLight::Light::Green | TrafficLight::Light::GreenCrossing)) != 0 && (lights & TrafficLight::Light::Yellow) == 0;
+}
+
+void SingleInterruptableCrossingSystem::requestSafePoint()
+{
+    _safePointRequested = true;
+    requestCrossing();
+}
\ No newline at end of file
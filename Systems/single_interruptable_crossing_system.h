@@ -1,13 +1,25 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <memory>
 #include <map>
 
 #include "abstract_system.h"
+#include "../request_channel.h"
+#include "../Hardware/hardware_types.h"
 
 class TrafficLight;
 class TrafficLightGroup;
+class CrossingButton;
+class StaticSequence;
+class GreenToRedSequence;
+class RedToGreenSequence;
+class RedCrossingToGreenCrossingSequence;
+class GreenCrossingToRedCrossingSequence;
+class FlashingCrossingToGreenSequence;
+class Controller;
+class ConflictMatrix;
 
 enum class SingleInterruptableCrossingSystemTimings
 {
@@ -17,28 +29,77 @@ enum class SingleInterruptableCrossingSystemTimings
     FlashInterval, //The time between flashes when CrossingStyle is set to Flashing.
     OffTimeBetweenGreenAndRedCrossing, //Time where both red and green crossing lights are off before switching back to red when CrossingStyle is set to Standard.
     DelayBetweenRedCrossingAndGreenLight, //Time after red crossing shows before lights change to green.
-    DelayBetweenCrossingRequests //The amount of time to wait in between requests to cross before changing again.
+    DelayBetweenCrossingRequests, //The amount of time to wait in between requests to cross before changing again.
+    Count //The number of timings, not a timing itself
 };
 
 /// @brief A system designed to handle a crossing across a single one way or two way road.
 class SingleInterruptableCrossingSystem : public AbstractSystem<SingleInterruptableCrossingSystemTimings>
 {
 public:
+    enum class Phase { Green, AwaitCrossing, GreenToRed, Crossing, Finished };
+
     enum class CrossingStyle { Standard, Flashing };
     enum class LightType { Red_Yellow_Green, Red_Green };
 
     SingleInterruptableCrossingSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights, CrossingStyle crossingStyle = CrossingStyle::Standard, LightType lightType = LightType::Red_Yellow_Green);
     SingleInterruptableCrossingSystem(std::shared_ptr<TrafficLightGroup> group, CrossingStyle crossingStyle = CrossingStyle::Standard, LightType lightType = LightType::Red_Yellow_Green);
     
+    /// @brief Requests a crossing from the core running the system. Requests from another core must be posted to
+    /// getRequestChannel() instead.
     void requestCrossing();
     void setCrossingStyle(CrossingStyle crossingStyle);
     void setLightType(LightType lightType);
-    void setTiming(SingleInterruptableCrossingSystemTimings timing, std::chrono::milliseconds time);
+    bool setTiming(SingleInterruptableCrossingSystemTimings timing, std::chrono::milliseconds time);
     void reset();
-    void run() override;
+    void start() override;
+
+    SystemStep advance() override;
+
+    /// @brief Gets the channel used to send requests from another core. Crossing events map to requestCrossing(), and
+    /// ModeChange events carry the CrossingStyle to switch to.
+    /// @param producer The channel to use, one for each producer, below RequestChannel::ProducerCount.
+    RequestChannel &getRequestChannel(size_t producer = 0);
+
+    size_t getModeCount() const override;
+
+    /// @brief Sets up a crossing button on the given input pin. Presses are picked up by interrupt and posted to
+    /// getRequestChannel(0), so nothing else should post to that channel once a button is set.
+    /// @param pin The input pin the button is wired to, reading high when pressed.
+    /// @param debounceTime Edges within this time of an accepted press are ignored as bounce.
+    void setCrossingButtonPin(uint pin, std::chrono::milliseconds debounceTime = std::chrono::milliseconds(50));
+
+    /// @brief Gets the time between the last serviced crossing being requested and the lights starting to change.
+    std::chrono::microseconds getCrossingLatency() const;
+
+    /// @brief Gets how long each time the system spent in the given phase took, including any time waiting for a request.
+    const DurationHistogram &getPhaseDurations(Phase phase) const;
+
+    const char *getPhaseName(uint8_t phase) const override;
+
+    bool isAtSafePoint() const override;
+    bool isHoldingStep() const override;
+    void requestSafePoint() override;
 
 private:
+    Phase _phase = Phase::Finished;
+    std::chrono::microseconds _phaseStartedAt = std::chrono::microseconds(0);
+    std::array<DurationHistogram, (size_t)Phase::Finished> _phaseDurations;
+
+    std::shared_ptr<Controller> _activeController;
+
+    //The controller whose lights are showing, kept while awaiting a request and after finishing.
+    std::shared_ptr<Controller> _shownController;
+
     bool _crossingRequested = false;
+    bool _safePointRequested = false;
+
+    std::chrono::microseconds _crossingRequestedAt = std::chrono::microseconds(0);
+    std::chrono::microseconds _crossingLatency = std::chrono::microseconds(0);
+
+    std::array<RequestChannel, RequestChannel::ProducerCount> _requests;
+
+    std::shared_ptr<CrossingButton> _crossingButton;
 
     CrossingStyle _crossingStyle = CrossingStyle::Standard;
     LightType _lightType = LightType::Red_Yellow_Green;
@@ -46,12 +107,32 @@ private:
     std::shared_ptr<TrafficLightGroup> _lightsGroup;
     std::map<SingleInterruptableCrossingSystemTimings, int> _delays;
 
+    std::shared_ptr<Controller> _staticGreenController;
+    std::shared_ptr<Controller> _greenToRedController;
+    std::shared_ptr<Controller> _standardCrossingController;
+    std::shared_ptr<Controller> _flashingCrossingController;
+
+    std::shared_ptr<ConflictMatrix> _conflicts;
+    std::shared_ptr<StaticSequence> _staticGreenSequence;
+    std::shared_ptr<GreenToRedSequence> _greenToRedSequence;
+    std::shared_ptr<RedCrossingToGreenCrossingSequence> _redCrossingToGreenCrossingSequence;
+    std::shared_ptr<StaticSequence> _staticOffSequence;
+    std::shared_ptr<GreenCrossingToRedCrossingSequence> _greenCrossingToRedCrossingSequence;
+    std::shared_ptr<RedToGreenSequence> _redToGreenSequence;
+    std::shared_ptr<FlashingCrossingToGreenSequence> _greenCrossingFlash;
+
     void setTrafficLights(std::vector<std::shared_ptr<TrafficLight>> trafficLights);
     void setUp();
-    void doGreen();
-    void doGreenToRed();
-    void doCrossing();
-    void awaitCrossingRequest();
+    void startGreenToRed();
+    void startCrossing();
+    void startPhase(Phase phase, std::shared_ptr<Controller> controller);
+    void finishPhase();
+    void processRequests();
+    void markCrossingRequested(std::chrono::microseconds requestedAt);
+
+    bool isCrossingRequested();
 
     std::chrono::milliseconds getStandardTiming(SingleInterruptableCrossingSystemTimings timing) const override;
+    std::chrono::milliseconds getMinimumTiming(SingleInterruptableCrossingSystemTimings timing) const override;
+    const char *describeTiming(SingleInterruptableCrossingSystemTimings timing) const override;
 };
\ No newline at end of file
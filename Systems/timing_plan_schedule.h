@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "timing_profile.h"
+#include "../time_of_day.h"
+
+/// @brief A set of named timing plans and the times of day to switch between them. Switch points are kept sorted as
+/// they're added, so finding the plan for a time of day is a binary search. A plan stays active from its switch point
+/// until the next one, wrapping round at midnight. The time comes from TimeOfDay, and until that has been set no plan is
+/// active, so systems keep the timings they have rather than switching plans at the wrong time.
+template<typename TimingEnum>
+class TimingPlanSchedule
+{
+public:
+    using Timings = TimingProfile<TimingEnum>;
+
+    static constexpr size_t MaximumPlans = 4;
+    static constexpr size_t MaximumSwitches = 16;
+    static constexpr size_t NoPlan = SIZE_MAX;
+
+    /// @brief Adds a plan. The name isn't copied, so it should be a string literal.
+    /// @return The index of the plan, or NoPlan if there's no room left.
+    size_t addPlan(const char *name, const Timings &timings)
+    {
+        if (_planCount >= MaximumPlans) {
+            return NoPlan;
+        }
+
+        _plans[_planCount] = { name, timings };
+
+        return _planCount++;
+    }
+
+    /// @brief Switches to the named plan at the given time of day each day, replacing any switch already at that time.
+    /// @return False if the plan doesn't exist or there's no room left.
+    bool addSwitch(std::chrono::minutes timeOfDay, const char *planName)
+    {
+        auto plan = findPlan(planName);
+        if (plan == NoPlan) {
+            return false;
+        }
+
+        timeOfDay = wrapTimeOfDay(timeOfDay);
+
+        auto end = _switches.begin() + _switchCount;
+        auto position = std::lower_bound(_switches.begin(), end, timeOfDay, [](const Switch &entry, std::chrono::minutes time) {
+            return entry.timeOfDay < time;
+        });
+
+        if (position != end && position->timeOfDay == timeOfDay) {
+            position->plan = plan;
+            return true;
+        }
+
+        if (_switchCount >= MaximumSwitches) {
+            return false;
+        }
+
+        std::move_backward(position, end, end + 1);
+        *position = { timeOfDay, plan };
+        ++_switchCount;
+
+        return true;
+    }
+
+    size_t findPlan(const char *name) const
+    {
+        for (size_t plan = 0; plan < _planCount; ++plan) {
+            if (strcmp(_plans[plan].name, name) == 0) {
+                return plan;
+            }
+        }
+
+        return NoPlan;
+    }
+
+    /// @brief The plan active at the given time of day. Before the first switch point of the day, the last one from the
+    /// day before still applies. With no switch points the first plan is always active.
+    size_t getPlanAt(std::chrono::minutes timeOfDay) const
+    {
+        if (_switchCount == 0) {
+            return _planCount > 0 ? 0 : NoPlan;
+        }
+
+        auto end = _switches.begin() + _switchCount;
+        auto next = std::upper_bound(_switches.begin(), end, wrapTimeOfDay(timeOfDay), [](std::chrono::minutes time, const Switch &entry) {
+            return time < entry.timeOfDay;
+        });
+
+        return next == _switches.begin() ? (end - 1)->plan : (next - 1)->plan;
+    }
+
+    /// @brief The plan active now, or NoPlan while the time of day isn't known.
+    size_t getActivePlan() const
+    {
+        return TimeOfDay::isSet() ? getPlanAt(TimeOfDay::get()) : NoPlan;
+    }
+
+    const Timings &getTimings(size_t plan) const
+    {
+        return _plans[plan].timings;
+    }
+
+    const char *getPlanName(size_t plan) const
+    {
+        return plan < _planCount ? _plans[plan].name : "";
+    }
+
+private:
+    struct Plan
+    {
+        const char *name = "";
+        Timings timings;
+    };
+
+    struct Switch
+    {
+        std::chrono::minutes timeOfDay;
+        size_t plan;
+    };
+
+    static std::chrono::minutes wrapTimeOfDay(std::chrono::minutes timeOfDay)
+    {
+        static constexpr auto day = std::chrono::minutes(std::chrono::hours(24));
+
+        timeOfDay %= day;
+        return timeOfDay < std::chrono::minutes(0) ? timeOfDay + day : timeOfDay;
+    }
+
+    std::array<Plan, MaximumPlans> _plans;
+    std::array<Switch, MaximumSwitches> _switches;
+    size_t _planCount = 0;
+    size_t _switchCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief A full set of timings for a system. Timings are kept in a dense table with a row for the system-wide timings
+/// and a row for each group up to MaximumGroups, so looking one up is a single array index. Groups without their own value
+/// follow the system-wide value. TimingEnum must end with a Count value.
+template<typename TimingEnum>
+class TimingProfile
+{
+public:
+    using Timing = TimingEnum;
+
+    static constexpr size_t TimingCount = static_cast<size_t>(TimingEnum::Count);
+    static constexpr int MaximumGroups = 8;
+
+    /// @brief Sets a timing for a group, or for every group without its own value when groupId is -1.
+    /// @return False, leaving the profile as it was, if the timing or group is out of range. Only groups below
+    /// MaximumGroups can have their own timings.
+    bool set(TimingEnum timingEnum, std::chrono::milliseconds time, int groupId = -1)
+    {
+        auto timing = static_cast<size_t>(timingEnum);
+        if (timing >= TimingCount || groupId < -1 || groupId >= MaximumGroups) {
+            return false;
+        }
+
+        if (groupId >= 0) {
+            _timings[groupId + 1][timing] = time;
+            _groupOverrides[groupId + 1] |= (1u << timing);
+            return true;
+        }
+
+        for (size_t row = 0; row < _timings.size(); ++row) {
+            if ((_groupOverrides[row] & (1u << timing)) == 0) {
+                _timings[row][timing] = time;
+            }
+        }
+
+        return true;
+    }
+
+    std::chrono::milliseconds get(TimingEnum timingEnum, int groupId = -1) const
+    {
+        auto timing = static_cast<size_t>(timingEnum);
+        if (timing >= TimingCount) {
+            return std::chrono::milliseconds(0);
+        }
+
+        auto row = (groupId >= 0 && groupId < MaximumGroups) ? groupId + 1 : 0;
+        return _timings[row][timing];
+    }
+
+private:
+    static_assert(TimingCount > 0 && TimingCount <= 32, "Timing overrides are tracked in a 32 bit mask");
+
+    std::array<std::array<std::chrono::milliseconds, TimingCount>, MaximumGroups + 1> _timings {};
+    std::array<uint32_t, MaximumGroups + 1> _groupOverrides {};
+};
\ No newline at end of file
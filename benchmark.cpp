@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Hardware/hardware.h"
+#include "Hardware/simulated_gpio.h"
+#include "Hardware/virtual_clock.h"
+
+#include "Systems/abstract_system.h"
+#include "Systems/light_test_system.h"
+
+#include "trafficlight.h"
+#include "trafficlight_group.h"
+#include "controller.h"
+#include "conflict_monitor.h"
+#include "common_sequences.h"
+#include "boot_pins.h"
+
+/// @brief One timed code path. Each call does some number of units of work, such as steps, and the cost is reported per
+/// unit.
+struct Benchmark
+{
+    std::string name;
+    std::string parameter;
+    std::function<size_t()> call;
+};
+
+struct BenchmarkResult
+{
+    size_t iterations = 0;
+    double medianNanoseconds = 0;
+    double minimumNanoseconds = 0;
+    double maximumNanoseconds = 0;
+};
+
+enum class BenchmarkTimings
+{
+    First,
+    Second,
+    Third,
+    Fourth,
+    Count
+};
+
+/// @brief A system that does nothing but expose getTiming.
+class TimingSystem : public AbstractSystem<BenchmarkTimings>
+{
+public:
+    TimingSystem()
+    {
+        setUpStandardTimings();
+        setTimingInternal(BenchmarkTimings::Third, std::chrono::milliseconds(250), 2);
+    }
+
+    void start() override {}
+
+    SystemStep advance() override
+    {
+        return SystemStep::finished();
+    }
+
+    std::chrono::milliseconds readTiming(BenchmarkTimings timing, int groupId) const
+    {
+        return getTiming(timing, groupId);
+    }
+
+private:
+    std::chrono::milliseconds getStandardTiming(BenchmarkTimings timing) const override
+    {
+        return std::chrono::milliseconds(100);
+    }
+};
+
+/// @brief Keeps a value alive so the compiler can't drop the work that made it.
+template<typename T>
+void keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+std::shared_ptr<TrafficLight> createTrafficLight(size_t pinCount, TrafficLight::LedType ledType, uint firstPin = 0)
+{
+    switch (pinCount) {
+        case 2:
+            return std::make_shared<TrafficLight>(firstPin, firstPin + 1, ledType);
+        case 3:
+            return std::make_shared<TrafficLight>(firstPin, firstPin + 1, firstPin + 2, ledType);
+        default:
+            return std::make_shared<TrafficLight>(firstPin, firstPin + 1, firstPin + 2, firstPin + 3, firstPin + 4, ledType);
+    }
+}
+
+static constexpr StoredConfig::Light JunctionLights[] = {
+    { 0, 1, 2, 3, 4, 1 },
+    { 5, 6, 7, 8, 9, 1 }
+};
+
+std::vector<std::shared_ptr<TrafficLight>> createJunctionLights()
+{
+    std::vector<std::shared_ptr<TrafficLight>> lights;
+    for (auto &light : JunctionLights) {
+        lights.push_back(std::make_shared<TrafficLight>(light.redPin, light.yellowPin, light.greenPin, light.redCrossingPin, light.greenCrossingPin, TrafficLight::LedType::CommonAnode));
+    }
+
+    return lights;
+}
+
+/// @brief How long the light test holds up the first system after reset, in virtual time.
+std::chrono::microseconds measureLightTestToRed(std::shared_ptr<VirtualClock> clock)
+{
+    auto system = std::make_shared<LightTestSystem>(createJunctionLights());
+    auto startedAt = clock->now();
+
+    system->start();
+    for (auto step = system->advance(); step.type != SystemStep::Type::Finished; step = system->advance()) {
+        if (step.type == SystemStep::Type::Delay) {
+            clock->sleepFor(step.delay);
+        }
+    }
+
+    return clock->now() - startedAt;
+}
+
+std::vector<Benchmark> createBenchmarks(std::shared_ptr<VirtualClock> clock)
+{
+    std::vector<Benchmark> benchmarks;
+
+    //Reset to red: the firmware drives every pin from a table in flash before anything else runs, rather than waiting
+    //for the lights to be constructed and shown red by a system.
+    static constexpr auto bootPins = BootPins::fromLights(JunctionLights);
+    benchmarks.push_back({ "reset to red", "boot pins", []() {
+        Hardware::gpio().initOutputPins(bootPins.mask, bootPins.safeValues);
+        return (size_t)1;
+    } });
+    benchmarks.push_back({ "reset to red", "construct and show", []() {
+        TrafficLightGroup group(createJunctionLights());
+        group.showLights((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+        return (size_t)1;
+    } });
+
+    for (auto ledType : { TrafficLight::LedType::CommonCathode, TrafficLight::LedType::CommonAnode }) {
+        for (size_t pinCount : { 2, 3, 5 }) {
+            auto light = createTrafficLight(pinCount, ledType);
+            auto on = false;
+
+            benchmarks.push_back({ "TrafficLight::setLightsState", std::to_string(pinCount) + " pins " + (ledType == TrafficLight::LedType::CommonAnode ? "common anode" : "common cathode"), [light, on]() mutable {
+                on = !on;
+                light->setLightsState(TrafficLight::Light::All, on);
+                return (size_t)1;
+            } });
+        }
+    }
+
+    for (size_t groupSize : { 1, 2, 4, 6 }) {
+        auto group = std::make_shared<TrafficLightGroup>();
+        for (size_t light = 0; light < groupSize; ++light) {
+            group->addTrafficLight(createTrafficLight(5, TrafficLight::LedType::CommonCathode, (uint)(light * 5)));
+        }
+
+        auto lights = std::make_shared<size_t>(0);
+        TrafficLight::Light pattern[] = { TrafficLight::Light::Red, TrafficLight::Light::Yellow, TrafficLight::Light::Green, TrafficLight::Light::RedCrossing };
+
+        benchmarks.push_back({ "TrafficLightGroup::showLights", std::to_string(groupSize) + " lights", [group, lights, pattern]() {
+            group->showLights(pattern[++*lights & 3]);
+            return (size_t)1;
+        } });
+    }
+
+    for (size_t stepCount : { 16, 64 }) {
+        auto group = std::make_shared<TrafficLightGroup>();
+        group->addTrafficLight(createTrafficLight(5, TrafficLight::LedType::CommonCathode, 0));
+        group->addTrafficLight(createTrafficLight(5, TrafficLight::LedType::CommonCathode, 5));
+
+        auto sequence = std::make_shared<Sequence>();
+        for (size_t step = 0; step < stepCount; ++step) {
+            sequence->add(step % 2 ? TrafficLight::Light::Red : TrafficLight::Light::Green, std::chrono::milliseconds(0));
+        }
+
+        auto controller = std::make_shared<Controller>();
+        controller->addTrafficLightGroup(group, 0);
+        controller->addSequence(sequence, 0);
+
+        benchmarks.push_back({ "Controller::run per step", std::to_string(stepCount) + " steps", [controller, stepCount]() {
+            controller->run();
+            return stepCount;
+        } });
+    }
+
+    for (size_t groupCount : { 2, 4, 6 }) {
+        std::vector<std::shared_ptr<TrafficLightGroup>> groups;
+        for (size_t group = 0; group < groupCount; ++group) {
+            groups.push_back(std::make_shared<TrafficLightGroup>(std::vector<std::shared_ptr<TrafficLight>> { createTrafficLight(5, TrafficLight::LedType::CommonCathode, (uint)(group * 5)) }));
+        }
+
+        //Only the first group is green, so every rule has to be checked.
+        auto matrix = std::make_shared<ConflictMatrix>(groups);
+        auto lit = groups[0]->getPinMask(TrafficLight::Light::Green);
+        for (size_t group = 1; group < groupCount; ++group) {
+            lit |= groups[group]->getPinMask(TrafficLight::Light::Red);
+        }
+
+        benchmarks.push_back({ "ConflictMatrix::check", std::to_string(groupCount) + " groups " + std::to_string(matrix->getRuleCount()) + " rules", [matrix, lit]() {
+            keep(matrix->check(lit));
+            return (size_t)1;
+        } });
+    }
+
+    auto system = std::make_shared<TimingSystem>();
+    benchmarks.push_back({ "AbstractSystem::getTiming", "system-wide", [system]() {
+        keep(system->readTiming(BenchmarkTimings::Second, -1));
+        return (size_t)1;
+    } });
+    benchmarks.push_back({ "AbstractSystem::getTiming", "group", [system]() {
+        keep(system->readTiming(BenchmarkTimings::Third, 2));
+        return (size_t)1;
+    } });
+
+    auto delay = std::chrono::seconds(1);
+    benchmarks.push_back({ "construct", "StaticSequence", [delay]() { keep(std::make_shared<StaticSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "GreenToRedSequence", [delay]() { keep(std::make_shared<GreenToRedSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "RedToGreenSequence", [delay]() { keep(std::make_shared<RedToGreenSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "RedCrossingToGreenCrossingSequence", [delay]() { keep(std::make_shared<RedCrossingToGreenCrossingSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "GreenCrossingToRedCrossingSequence", [delay]() { keep(std::make_shared<GreenCrossingToRedCrossingSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "FlashingSequence", []() { keep(std::make_shared<FlashingSequence>(TrafficLight::Light::Yellow)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "FlashingCrossingToGreenSequence", [delay]() { keep(std::make_shared<FlashingCrossingToGreenSequence>(delay)); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "YellowFlashingSequence", []() { keep(std::make_shared<YellowFlashingSequence>()); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "RedFlashingSequence", []() { keep(std::make_shared<RedFlashingSequence>()); return (size_t)1; } });
+    benchmarks.push_back({ "construct", "TestSequence", []() { keep(std::make_shared<TestSequence>()); return (size_t)1; } });
+
+    return benchmarks;
+}
+
+/// @brief Times batches of calls, each long enough to be measured reliably, and takes the median over the batches so one
+/// slow batch doesn't move the result.
+BenchmarkResult runBenchmark(const Benchmark &benchmark, std::chrono::nanoseconds batchTime, size_t batches)
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t callsPerBatch = 1;
+    while (true) {
+        auto startedAt = Clock::now();
+        for (size_t call = 0; call < callsPerBatch; ++call) {
+            benchmark.call();
+        }
+
+        if (Clock::now() - startedAt >= batchTime / 4 || callsPerBatch >= ((size_t)1 << 30)) {
+            callsPerBatch *= 4;
+            break;
+        }
+
+        callsPerBatch *= 2;
+    }
+
+    std::vector<double> costs;
+    BenchmarkResult result;
+
+    for (size_t batch = 0; batch < batches; ++batch) {
+        size_t units = 0;
+
+        auto startedAt = Clock::now();
+        for (size_t call = 0; call < callsPerBatch; ++call) {
+            units += benchmark.call();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startedAt);
+
+        costs.push_back((double)elapsed.count() / (double)std::max<size_t>(units, 1));
+        result.iterations += units;
+    }
+
+    std::sort(costs.begin(), costs.end());
+    result.medianNanoseconds = costs[costs.size() / 2];
+    result.minimumNanoseconds = costs.front();
+    result.maximumNanoseconds = costs.back();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    auto json = false;
+    auto batchTime = std::chrono::milliseconds(20);
+    size_t batches = 9;
+    const char *filter = nullptr;
+
+    for (auto argument = 1; argument < argc; ++argument) {
+        if (strcmp(argv[argument], "--json") == 0) {
+            json = true;
+        }
+        else if (strcmp(argv[argument], "--csv") == 0) {
+            json = false;
+        }
+        else if (strcmp(argv[argument], "--batches") == 0 && argument + 1 < argc) {
+            batches = std::max(1, atoi(argv[++argument]));
+        }
+        else if (strcmp(argv[argument], "--batch-ms") == 0 && argument + 1 < argc) {
+            batchTime = std::chrono::milliseconds(std::max(1, atoi(argv[++argument])));
+        }
+        else if (strcmp(argv[argument], "--filter") == 0 && argument + 1 < argc) {
+            filter = argv[++argument];
+        }
+        else {
+            fprintf(stderr, "usage: %s [--csv | --json] [--batches n] [--batch-ms ms] [--filter text]\n", argv[0]);
+            return 1;
+        }
+    }
+
+#ifndef __OPTIMIZE__
+    fprintf(stderr, "built without optimisation, configure with -DCMAKE_BUILD_TYPE=Release for numbers worth comparing\n");
+#endif
+
+    auto gpio = std::make_shared<SimulatedGpio>();
+    auto clock = std::make_shared<VirtualClock>();
+
+    Hardware::setGpio(gpio);
+    Hardware::setClock(clock);
+
+    //On the board the boot pins are driven within microseconds of reset, but without them nothing shows until the first
+    //system runs, after the light test.
+    fprintf(stderr, "reset to red without boot pins: %lld ms of light test first\n", (long long)std::chrono::duration_cast<std::chrono::milliseconds>(measureLightTestToRed(clock)).count());
+
+    if (json) {
+        printf("[\n");
+    }
+    else {
+        printf("benchmark,parameter,units,median_ns,min_ns,max_ns\n");
+    }
+
+    auto first = true;
+    for (auto &benchmark : createBenchmarks(clock)) {
+        if (filter && (benchmark.name + " " + benchmark.parameter).find(filter) == std::string::npos) {
+            continue;
+        }
+
+        auto result = runBenchmark(benchmark, batchTime, batches);
+
+        if (json) {
+            printf("%s  {\"benchmark\": \"%s\", \"parameter\": \"%s\", \"units\": %zu, \"median_ns\": %.2f, \"min_ns\": %.2f, \"max_ns\": %.2f}",
+                first ? "" : ",\n", benchmark.name.c_str(), benchmark.parameter.c_str(), result.iterations, result.medianNanoseconds, result.minimumNanoseconds, result.maximumNanoseconds);
+        }
+        else {
+            printf("%s,%s,%zu,%.2f,%.2f,%.2f\n", benchmark.name.c_str(), benchmark.parameter.c_str(), result.iterations, result.medianNanoseconds, result.minimumNanoseconds, result.maximumNanoseconds);
+        }
+
+        first = false;
+        fflush(stdout);
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+
+    return 0;
+}
\ No newline at end of file
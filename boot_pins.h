@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "stored_config.h"
+
+/// @brief Every pin used by a set of traffic lights, and the values that show them all on red. It is worked out at
+/// compile time from the built in set up so it sits in flash as two words, ready to be driven straight after reset,
+/// before the heap or any static constructor is.
+struct BootPins
+{
+    uint32_t mask = 0;
+    uint32_t safeValues = 0;
+
+    template<size_t Count>
+    static constexpr BootPins fromLights(const StoredConfig::Light (&lights)[Count])
+    {
+        return fromLights(lights, Count);
+    }
+
+    static constexpr BootPins fromLights(const StoredConfig::Light *lights, size_t count)
+    {
+        BootPins pins;
+
+        for (size_t index = 0; index < count; ++index) {
+            auto &light = lights[index];
+
+            pins.add(light.redPin, true, light.commonAnode);
+            pins.add(light.yellowPin, false, light.commonAnode);
+            pins.add(light.greenPin, false, light.commonAnode);
+            pins.add(light.redCrossingPin, true, light.commonAnode);
+            pins.add(light.greenCrossingPin, false, light.commonAnode);
+        }
+
+        return pins;
+    }
+
+private:
+    constexpr void add(uint8_t pin, bool lit, uint8_t commonAnode)
+    {
+        if (pin >= 32) {
+            return;
+        }
+
+        mask |= 1u << pin;
+
+        //Common anode lights are lit by pulling the pin low.
+        if (lit != (commonAnode != 0)) {
+            safeValues |= 1u << pin;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+
+#include "fixed_sequence.h"
+#include "common_sequences.h"
+
+// Compile time equivalents of the sequences in common_sequences.h. Declare the results as constexpr (static) variables
+// so they are built by the compiler and stored in flash.
+
+constexpr FixedSequence<1> makeStaticSequence(std::chrono::milliseconds delay, TrafficLight::Light light = (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing))
+{
+    FixedSequence<1> sequence;
+    sequence.add(light, delay);
+
+    return sequence;
+}
+
+constexpr FixedSequence<2> makeGreenToRedSequence(std::chrono::milliseconds delay, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
+{
+    FixedSequence<2> sequence;
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing), yellowTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing), delay);
+
+    return sequence;
+}
+
+constexpr FixedSequence<2> makeRedToGreenSequence(std::chrono::milliseconds delay, RedToGreenSequence::SequenceType sequenceType = RedToGreenSequence::SequenceType::Red_Yellow_Green, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
+{
+    FixedSequence<2> sequence;
+
+    if (sequenceType == RedToGreenSequence::SequenceType::Red_Yellow_Green) {
+        sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing), yellowTime);
+    }
+
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing), delay);
+
+    return sequence;
+}
+
+constexpr FixedSequence<1> makeRedCrossingToGreenCrossingSequence(std::chrono::milliseconds delay)
+{
+    return makeStaticSequence(delay, (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::GreenCrossing));
+}
+
+constexpr FixedSequence<1> makeGreenCrossingToRedCrossingSequence(std::chrono::milliseconds delay)
+{
+    return makeStaticSequence(delay, (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+}
+
+constexpr FixedSequence<3> makeFlashingSequence(TrafficLight::Light light, TrafficLight::Light staticLights = TrafficLight::Light::RedCrossing, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
+{
+    FixedSequence<3> sequence;
+
+    if (numberOfFlashes > 0) {
+        sequence.add(staticLights, flashTime);
+        sequence.add(light, flashTime);
+    }
+
+    if (numberOfFlashes > 1) {
+        sequence.repeat(2, numberOfFlashes);
+    }
+
+    return sequence;
+}
+
+constexpr FixedSequence<4> makeFlashingCrossingToGreenSequence(std::chrono::milliseconds postFlashDelay, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
+{
+    FixedSequence<4> sequence;
+
+    if (numberOfFlashes > 0) {
+        sequence.add(TrafficLight::Light::None, flashTime);
+        sequence.add((TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::GreenCrossing), flashTime);
+    }
+
+    if (numberOfFlashes > 1) {
+        sequence.repeat(2, numberOfFlashes);
+    }
+
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing), postFlashDelay);
+
+    return sequence;
+}
+
+constexpr FixedSequence<17> makeTestSequence(std::chrono::milliseconds animationTime = std::chrono::milliseconds(300))
+{
+    FixedSequence<17> sequence;
+    sequence.add(TrafficLight::Light::All, animationTime);
+    sequence.add(TrafficLight::Light::Red, animationTime);
+    sequence.add(TrafficLight::Light::Yellow, animationTime);
+    sequence.add(TrafficLight::Light::Green, animationTime);
+    sequence.add(TrafficLight::Light::RedCrossing, animationTime);
+    sequence.add(TrafficLight::Light::GreenCrossing, animationTime);
+    sequence.add(TrafficLight::Light::None, animationTime);
+    sequence.add(TrafficLight::Light::Red, animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow), animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::Green), animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::Green | TrafficLight::Light::RedCrossing), animationTime);
+    sequence.add(TrafficLight::Light::All, animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::Green | TrafficLight::Light::RedCrossing), animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::Green), animationTime);
+    sequence.add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow), animationTime);
+    sequence.add(TrafficLight::Light::Red, animationTime);
+    sequence.add(TrafficLight::Light::None, animationTime);
+
+    return sequence;
+}
@@ -4,11 +4,20 @@
 
 #include "sequence.h"
 
+// Each sequence can be rebuilt in place with set(), which reuses the storage from the last build, so systems can create
+// their sequences once and update their timings on every run without going back to the heap.
+
 class StaticSequence : public Sequence
 {
 public:
     StaticSequence(std::chrono::milliseconds delay, TrafficLight::Light light = (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing))
     {
+        set(delay, light);
+    }
+
+    void set(std::chrono::milliseconds delay, TrafficLight::Light light = (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing))
+    {
+        clear();
         add(light, delay);
     }
 };
@@ -18,6 +27,12 @@ class GreenToRedSequence : public Sequence
 public:
     GreenToRedSequence(std::chrono::milliseconds delay, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
     {
+        set(delay, yellowTime);
+    }
+
+    void set(std::chrono::milliseconds delay, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
+    {
+        clear();
         add((TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing), yellowTime);
         add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing), delay);
     }
@@ -30,6 +45,13 @@ public:
 
     RedToGreenSequence(std::chrono::milliseconds delay, SequenceType sequenceType = SequenceType::Red_Yellow_Green, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
     {
+        set(delay, sequenceType, yellowTime);
+    }
+
+    void set(std::chrono::milliseconds delay, SequenceType sequenceType = SequenceType::Red_Yellow_Green, std::chrono::milliseconds yellowTime = std::chrono::seconds(3))
+    {
+        clear();
+
         if (sequenceType == SequenceType::Red_Yellow_Green) {
             add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::Yellow | TrafficLight::Light::RedCrossing), yellowTime);
         }
@@ -43,6 +65,12 @@ class RedCrossingToGreenCrossingSequence : public Sequence
 public:
     RedCrossingToGreenCrossingSequence(std::chrono::milliseconds delay)
     {
+        set(delay);
+    }
+
+    void set(std::chrono::milliseconds delay)
+    {
+        clear();
         add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::GreenCrossing), delay);
     }
 };
@@ -52,6 +80,12 @@ class GreenCrossingToRedCrossingSequence : public Sequence
 public:
     GreenCrossingToRedCrossingSequence(std::chrono::milliseconds delay)
     {
+        set(delay);
+    }
+
+    void set(std::chrono::milliseconds delay)
+    {
+        clear();
         add((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing), delay);
     }
 };
@@ -61,6 +95,12 @@ class FlashingSequence : public Sequence
 public:
     FlashingSequence(TrafficLight::Light light, TrafficLight::Light staticLights = TrafficLight::Light::RedCrossing, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
     {
+        set(light, staticLights, numberOfFlashes, flashTime);
+    }
+
+    void set(TrafficLight::Light light, TrafficLight::Light staticLights = TrafficLight::Light::RedCrossing, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
+    {
+        clear();
         addFlashes(light, staticLights, numberOfFlashes, flashTime);
     }
 
@@ -71,9 +111,13 @@ protected:
 
     void addFlashes(TrafficLight::Light light, TrafficLight::Light staticLights = TrafficLight::Light::RedCrossing, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
     {
-        for (unsigned int count = 0; count < numberOfFlashes; ++count) {
+        if (numberOfFlashes > 0) {
             addFlash(light, staticLights, flashTime);
         }
+
+        if (numberOfFlashes > 1) {
+            repeat(2, numberOfFlashes);
+        }
     }
 
     void addFlash(TrafficLight::Light light, TrafficLight::Light staticLights = TrafficLight::Light::RedCrossing, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
@@ -88,6 +132,12 @@ class FlashingCrossingToGreenSequence : public FlashingSequence
 public:
     FlashingCrossingToGreenSequence(std::chrono::milliseconds postFlashDelay, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500)) : FlashingSequence()
     {
+        set(postFlashDelay, numberOfFlashes, flashTime);
+    }
+
+    void set(std::chrono::milliseconds postFlashDelay, unsigned int numberOfFlashes = 5, std::chrono::milliseconds flashTime = std::chrono::milliseconds(500))
+    {
+        clear();
         addFlashes((TrafficLight::Light)(TrafficLight::Light::Yellow | TrafficLight::Light::GreenCrossing), TrafficLight::Light::None, numberOfFlashes, flashTime);
         add((TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::RedCrossing), postFlashDelay);
     }
@@ -114,6 +164,12 @@ class TestSequence : public Sequence
 public:
     TestSequence(std::chrono::milliseconds animationTime = std::chrono::milliseconds(300))
     {
+        set(animationTime);
+    }
+
+    void set(std::chrono::milliseconds animationTime = std::chrono::milliseconds(300))
+    {
+        clear();
         add(TrafficLight::Light::All, animationTime);
         add(TrafficLight::Light::Red, animationTime);
         add(TrafficLight::Light::Yellow, animationTime);
@@ -132,4 +188,4 @@ public:
         add(TrafficLight::Light::Red, animationTime);
         add(TrafficLight::Light::None, animationTime);
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,133 @@
+#include "Hardware/hardware.h"
+
+#include "step_scheduler.h"
+#include "trace_recorder.h"
+#include "conflict_monitor.h"
+#include "heartbeat.h"
+#include "compiled_timeline.h"
+
+void CompiledTimeline::clear()
+{
+    _frames.clear();
+    start();
+}
+
+void CompiledTimeline::addFrame(std::chrono::milliseconds duration, uint32_t setMask, uint32_t clearMask, uint8_t traceGroupId, uint8_t lights)
+{
+    TimelineFrame frame;
+    frame.duration = duration;
+    frame.setMask = setMask;
+    frame.clearMask = clearMask;
+    frame.traceGroupId = traceGroupId;
+    frame.lights = lights;
+
+    _frames.push_back(frame);
+}
+
+void CompiledTimeline::setConflictMatrix(const ConflictMatrix *matrix)
+{
+    _conflicts = matrix;
+}
+
+void CompiledTimeline::addRepeat(uint16_t blockLength, uint16_t times)
+{
+    TimelineFrame frame;
+    frame.repeatBlock = blockLength;
+    frame.repeatCount = times;
+
+    _frames.push_back(frame);
+}
+
+size_t CompiledTimeline::count() const
+{
+    return _frames.size();
+}
+
+const TimelineFrame *CompiledTimeline::getFrames() const
+{
+    return _frames.data();
+}
+
+std::chrono::milliseconds CompiledTimeline::getDuration() const
+{
+    auto duration = std::chrono::milliseconds(0);
+
+    for (size_t index = 0; index < _frames.size(); ++index) {
+        auto &frame = _frames[index];
+
+        if (frame.repeatCount == 0) {
+            duration += frame.duration;
+            continue;
+        }
+
+        auto blockTime = std::chrono::milliseconds(0);
+        for (size_t block = index - frame.repeatBlock; block < index; ++block) {
+            blockTime += _frames[block].duration;
+        }
+
+        duration += blockTime * (frame.repeatCount - 1);
+    }
+
+    return duration;
+}
+
+void CompiledTimeline::run()
+{
+    std::chrono::milliseconds delay;
+
+    start();
+
+    while (advance(delay)) {
+        StepScheduler::waitFor(delay);
+    }
+}
+
+uint8_t CompiledTimeline::getShownLights() const
+{
+    return _shownLights;
+}
+
+void CompiledTimeline::start()
+{
+    _index = 0;
+    _repeatIterations = 0;
+    _shownLights = 0;
+}
+
+bool CompiledTimeline::advance(std::chrono::milliseconds &delay)
+{
+    while (_index < _frames.size()) {
+        auto &frame = _frames[_index];
+
+        if (frame.repeatCount > 0) {
+            if (++_repeatIterations < frame.repeatCount) {
+                _index -= frame.repeatBlock;
+            }
+            else {
+                _repeatIterations = 0;
+                ++_index;
+            }
+
+            continue;
+        }
+
+        ++_index;
+
+        Heartbeat::beat();
+
+        auto mask = frame.setMask | frame.clearMask;
+        if (mask != 0) {
+            ConflictMonitor::commit(_conflicts, mask, frame.setMask);
+            TraceRecorder::record(frame.traceGroupId, frame.lights, TraceRecord::Cause::SequenceStep);
+        }
+
+        delay = frame.duration;
+        _shownLights = frame.lights;
+
+        return true;
+    }
+
+    start();
+
+    return false;
+}
\ No newline at end of file
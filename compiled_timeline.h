@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ConflictMatrix;
+
+/// @brief A single entry of a compiled timeline. Either drives the pins in setMask high and the pins in clearMask low
+/// for duration, or when repeatCount is set, sends the timeline back over the repeatBlock frames before it until they
+/// have run repeatCount times in total.
+struct TimelineFrame
+{
+    std::chrono::milliseconds duration = std::chrono::milliseconds(0);
+    uint32_t setMask = 0;
+    uint32_t clearMask = 0;
+    uint16_t repeatBlock = 0;
+    uint16_t repeatCount = 0;
+    uint8_t traceGroupId = 0;
+    uint8_t lights = 0;
+};
+
+/// @brief A Controller flattened into frames of raw pin masks, so replaying it is a single masked write per frame with
+/// no group or sequence lookups. Built by Controller::compile().
+class CompiledTimeline
+{
+public:
+    void clear();
+    /// @brief Adds a frame. The group id and lights are only kept for the trace.
+    void addFrame(std::chrono::milliseconds duration, uint32_t setMask, uint32_t clearMask, uint8_t traceGroupId = 0, uint8_t lights = 0);
+    void addRepeat(uint16_t blockLength, uint16_t times);
+
+    /// @brief Sets the rules every frame is checked against by the ConflictMonitor before it is written, or null to not
+    /// check. The matrix isn't copied.
+    void setConflictMatrix(const ConflictMatrix *matrix);
+
+    size_t count() const;
+    const TimelineFrame *getFrames() const;
+
+    /// @brief Total time taken to replay the timeline once.
+    std::chrono::milliseconds getDuration() const;
+
+    void run();
+
+    /// @brief Starts replaying from the first frame without blocking. See advance().
+    void start();
+
+    /// @brief Writes the next frame's pins and returns how long they should be held for.
+    /// @param delay Set to the duration of the frame that was written.
+    /// @return False once every frame has been written.
+    bool advance(std::chrono::milliseconds &delay);
+
+    /// @brief The lights of the frame last written since the timeline was started, or 0 if none has been.
+    uint8_t getShownLights() const;
+
+private:
+    size_t _index = 0;
+    uint8_t _shownLights = 0;
+    uint32_t _repeatIterations = 0;
+
+    const ConflictMatrix *_conflicts = nullptr;
+
+    std::vector<TimelineFrame> _frames;
+};
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include <cstddef>
+#include <cstring>
+
+#include "Hardware/hardware.h"
+
+#include "config_store.h"
+
+void ConfigStore::load()
+{
+    _newestSlot = NoSlot;
+    _newest = {};
+
+    uint8_t payload[MaximumLength];
+
+    for (size_t slot = 0; slot < getSlotCount(); ++slot) {
+        Header header;
+        if (!readSlot(slot, header, payload)) {
+            continue;
+        }
+
+        //Compared by difference so the sequence can wrap.
+        if (_newestSlot == NoSlot || (int32_t)(header.sequence - _newest.sequence) > 0) {
+            _newestSlot = slot;
+            _newest = header;
+        }
+    }
+}
+
+bool ConfigStore::read(uint16_t version, void *data, size_t length) const
+{
+    if (_newestSlot == NoSlot || _newest.version != version || _newest.length != length) {
+        return false;
+    }
+
+    uint8_t payload[MaximumLength];
+    Header header;
+
+    if (!readSlot(_newestSlot, header, payload)) {
+        return false;
+    }
+
+    memcpy(data, payload, length);
+
+    return true;
+}
+
+bool ConfigStore::write(uint16_t version, const void *data, size_t length)
+{
+    if (length > MaximumLength || getSlotsPerSector() == 0 || Hardware::flash().getSectorCount() < 2) {
+        return false;
+    }
+
+    Header header;
+    header.magic = Magic;
+    header.sequence = _newestSlot == NoSlot ? 1 : _newest.sequence + 1;
+    header.length = (uint16_t)length;
+    header.version = version;
+    header.crc = crc32(data, length, crc32(&header, offsetof(Header, crc)));
+
+    uint8_t slotData[SlotSize];
+    memset(slotData, 0xff, sizeof(slotData));
+    memcpy(slotData, &header, sizeof(header));
+    memcpy(slotData + HeaderSize, data, length);
+
+    auto slotsPerSector = getSlotsPerSector();
+    auto slot = _newestSlot == NoSlot ? 0 : _newestSlot + 1;
+
+    for (size_t attempt = 0; attempt < getSlotCount(); ++attempt, ++slot) {
+        slot %= getSlotCount();
+
+        if (slot % slotsPerSector == 0) {
+            //Never erase the newest good copy, even if every other slot has failed.
+            if (_newestSlot != NoSlot && slot / slotsPerSector == _newestSlot / slotsPerSector) {
+                return false;
+            }
+
+            Hardware::flash().erase(slot / slotsPerSector);
+        }
+        else if (!isBlank(slot)) {
+            //Left over from a write cut short, so it can't be programmed over.
+            continue;
+        }
+
+        Hardware::flash().program(slot * SlotSize, slotData, SlotSize);
+
+        uint8_t payload[MaximumLength];
+        Header written;
+
+        if (readSlot(slot, written, payload) && written.sequence == header.sequence) {
+            _newestSlot = slot;
+            _newest = written;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ConfigStore::hasRecord() const
+{
+    return _newestSlot != NoSlot;
+}
+
+uint32_t ConfigStore::getSequence() const
+{
+    return _newest.sequence;
+}
+
+uint32_t ConfigStore::crc32(const void *data, size_t length, uint32_t crc)
+{
+    auto bytes = (const uint8_t *)data;
+
+    crc = ~crc;
+    for (size_t index = 0; index < length; ++index) {
+        crc ^= bytes[index];
+
+        for (auto bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+        }
+    }
+
+    return ~crc;
+}
+
+size_t ConfigStore::getSlotCount() const
+{
+    return getSlotsPerSector() * Hardware::flash().getSectorCount();
+}
+
+size_t ConfigStore::getSlotsPerSector() const
+{
+    return Hardware::flash().getSectorSize() / SlotSize;
+}
+
+bool ConfigStore::readSlot(size_t slot, Header &header, uint8_t *payload) const
+{
+    Hardware::flash().read(slot * SlotSize, &header, sizeof(header));
+
+    if (header.magic != Magic || header.length > MaximumLength) {
+        return false;
+    }
+
+    Hardware::flash().read(slot * SlotSize + HeaderSize, payload, header.length);
+
+    return crc32(payload, header.length, crc32(&header, offsetof(Header, crc))) == header.crc;
+}
+
+bool ConfigStore::isBlank(size_t slot) const
+{
+    uint8_t slotData[SlotSize];
+    Hardware::flash().read(slot * SlotSize, slotData, sizeof(slotData));
+
+    for (auto byte : slotData) {
+        if (byte != 0xff) {
+            return false;
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
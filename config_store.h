@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Keeps a small record in the flash from Hardware::flash(), surviving power cuts at any point. Every write
+/// appends a whole new copy to the next free page, working round all the sectors in turn so they wear evenly, and only
+/// erases a sector once the newest copy has moved on from it. Each copy carries a sequence number, a version and a CRC,
+/// so a copy torn by a power cut is never mistaken for a good one and the previous copy is read instead.
+class ConfigStore
+{
+public:
+    static constexpr uint32_t Magic = 0x434c5450; //"PTLC"
+    static constexpr size_t SlotSize = 256;
+    static constexpr size_t HeaderSize = 16;
+    static constexpr size_t MaximumLength = SlotSize - HeaderSize;
+
+    /// @brief Scans every slot once to find the newest good copy and where the next one goes. Call before reading or
+    /// writing, and again if the flash is changed underneath.
+    void load();
+
+    /// @brief Copies out the newest record, if it was written with the same version and length.
+    bool read(uint16_t version, void *data, size_t length) const;
+
+    /// @brief Appends a new copy of the record, erasing the next sector first if it is needed.
+    /// @return False if the record is too long or couldn't be written.
+    bool write(uint16_t version, const void *data, size_t length);
+
+    bool hasRecord() const;
+
+    /// @brief The sequence number of the newest copy, which counts every write ever made.
+    uint32_t getSequence() const;
+
+    static uint32_t crc32(const void *data, size_t length, uint32_t crc = 0);
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t sequence;
+        uint16_t length;
+        uint16_t version;
+        uint32_t crc;
+    };
+
+    static_assert(sizeof(Header) == HeaderSize, "ConfigStore header must be packed");
+
+    static constexpr size_t NoSlot = (size_t)-1;
+
+    size_t _newestSlot = NoSlot;
+    Header _newest = {};
+
+    size_t getSlotCount() const;
+    size_t getSlotsPerSector() const;
+
+    bool readSlot(size_t slot, Header &header, uint8_t *payload) const;
+    bool isBlank(size_t slot) const;
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "Hardware/hardware.h"
+#include "trafficlight_group.h"
+#include "trace_recorder.h"
+
+#include "conflict_monitor.h"
+
+uint32_t ConflictMonitor::_pins = 0;
+uint32_t ConflictMonitor::_writtenPins = 0;
+
+std::atomic<uint8_t> ConflictMonitor::_fault = (uint8_t)ConflictFault::None;
+std::atomic<uint32_t> ConflictMonitor::_faultPins = 0;
+
+ConflictMatrix::ConflictMatrix(const std::vector<std::shared_ptr<TrafficLightGroup>> &groups)
+{
+    static constexpr auto SafeLights = (TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing);
+
+    uint32_t safePins = 0;
+
+    for (size_t index = 0; index < groups.size(); ++index) {
+        auto &group = *groups[index];
+
+        _bankMask |= group.getBankMask();
+        _invertMask |= group.getInvertMask();
+        safePins |= group.getPinMask(SafeLights);
+
+        //Checking each group against every later one at once covers every pair.
+        uint32_t laterGreens = 0;
+        for (size_t later = index + 1; later < groups.size(); ++later) {
+            laterGreens |= groups[later]->getPinMask(TrafficLight::Light::Green);
+        }
+
+        auto greens = group.getPinMask(TrafficLight::Light::Green);
+        if (greens != 0 && laterGreens != 0 && !addRule(greens, laterGreens, ConflictFault::ConflictingGreens)) {
+            _complete = false;
+        }
+
+        for (auto &trafficLight : group.getTrafficLights()) {
+            auto green = trafficLight->getPinMask(TrafficLight::Light::Green);
+            auto greenCrossing = trafficLight->getPinMask(TrafficLight::Light::GreenCrossing);
+
+            if (green != 0 && greenCrossing != 0 && !addRule(green, greenCrossing, ConflictFault::GreenWithCrossing)) {
+                _complete = false;
+            }
+        }
+    }
+
+    _safeValues = (safePins ^ _invertMask) & _bankMask;
+}
+
+bool ConflictMatrix::addRule(uint32_t first, uint32_t second, ConflictFault fault)
+{
+    if (_ruleCount >= MaximumRules) {
+        return false;
+    }
+
+    _rules[_ruleCount++] = { first, second, fault };
+
+    return true;
+}
+
+ConflictFault ConflictMatrix::check(uint32_t lit) const
+{
+    for (size_t index = 0; index < _ruleCount; ++index) {
+        auto &rule = _rules[index];
+
+        if ((lit & rule.first) != 0 && (lit & rule.second) != 0) {
+            return rule.fault;
+        }
+    }
+
+    return ConflictFault::None;
+}
+
+size_t ConflictMatrix::getRuleCount() const
+{
+    return _ruleCount;
+}
+
+bool ConflictMatrix::isComplete() const
+{
+    return _complete;
+}
+
+uint32_t ConflictMatrix::getBankMask() const
+{
+    return _bankMask;
+}
+
+uint32_t ConflictMatrix::getInvertMask() const
+{
+    return _invertMask;
+}
+
+uint32_t ConflictMatrix::getSafeValues() const
+{
+    return _safeValues;
+}
+
+bool ConflictMonitor::commit(const ConflictMatrix *matrix, uint32_t mask, uint32_t values)
+{
+    if (_fault.load(std::memory_order_relaxed) != (uint8_t)ConflictFault::None) {
+        return false;
+    }
+
+    auto pins = (_pins & ~mask) | (values & mask);
+    auto writtenPins = _writtenPins | mask;
+
+    if (matrix) {
+        auto lit = (pins ^ matrix->getInvertMask()) & matrix->getBankMask() & writtenPins;
+        //A matrix missing rules can't say a step is safe, so stops the lights as if the step broke one.
+        auto fault = matrix->isComplete() ? matrix->check(lit) : ConflictFault::TooManyRules;
+
+        if (fault != ConflictFault::None) {
+            _pins = (_pins & ~matrix->getBankMask()) | matrix->getSafeValues();
+            _writtenPins |= matrix->getBankMask();
+            Hardware::gpio().putMasked(matrix->getBankMask(), matrix->getSafeValues());
+
+            _faultPins.store(lit, std::memory_order_relaxed);
+            _fault.store((uint8_t)fault, std::memory_order_relaxed);
+            TraceRecorder::record(TraceRecord::NoGroup, (uint8_t)fault, TraceRecord::Cause::ConflictFault);
+
+            return false;
+        }
+    }
+
+    _pins = pins;
+    _writtenPins = writtenPins;
+    Hardware::gpio().putMasked(mask, values);
+
+    return true;
+}
+
+ConflictFault ConflictMonitor::getFault()
+{
+    return (ConflictFault)_fault.load(std::memory_order_relaxed);
+}
+
+uint32_t ConflictMonitor::getFaultPins()
+{
+    return _faultPins.load(std::memory_order_relaxed);
+}
+
+void ConflictMonitor::clearFault()
+{
+    _fault.store((uint8_t)ConflictFault::None, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class TrafficLightGroup;
+
+/// @brief Why the conflict monitor stopped the lights.
+enum class ConflictFault : uint8_t
+{
+    None,
+    ConflictingGreens, //Two groups that take turns showed green at the same time.
+    GreenWithCrossing, //A vehicle light showed green along with its own green crossing light.
+    TooManyRules //The groups needed more rules than a ConflictMatrix holds, so their steps couldn't all be checked.
+};
+
+/// @brief The pairs of lights that must never be lit together, worked out once from the groups a system takes turns
+/// between. Checking a frame is one pair of ANDs per rule.
+class ConflictMatrix
+{
+public:
+    static constexpr size_t MaximumRules = 16;
+
+    /// @brief Builds the rules for groups that take turns, so no two groups may show green at once and no traffic light
+    /// may show green along with its own green crossing light. Red and red crossing on every light is the safe state. If
+    /// the rules don't all fit, the matrix is left incomplete, and every step checked against it faults.
+    ConflictMatrix(const std::vector<std::shared_ptr<TrafficLightGroup>> &groups);
+
+    /// @brief Adds a rule that the first and second pins must never be lit at the same time.
+    /// @return False if there are already MaximumRules.
+    bool addRule(uint32_t first, uint32_t second, ConflictFault fault);
+
+    /// @brief Checks which pins would be lit, after the LED type has been taken into account.
+    ConflictFault check(uint32_t lit) const;
+
+    size_t getRuleCount() const;
+
+    /// @brief Whether every rule the groups needed fitted, so checking against the matrix covers them all.
+    bool isComplete() const;
+
+    uint32_t getBankMask() const;
+    uint32_t getInvertMask() const;
+
+    /// @brief Gets the pin values that show red and red crossing on every light.
+    uint32_t getSafeValues() const;
+
+private:
+    struct Rule
+    {
+        uint32_t first = 0;
+        uint32_t second = 0;
+        ConflictFault fault = ConflictFault::None;
+    };
+
+    std::array<Rule, MaximumRules> _rules;
+    size_t _ruleCount = 0;
+    bool _complete = true;
+
+    uint32_t _bankMask = 0;
+    uint32_t _invertMask = 0;
+    uint32_t _safeValues = 0;
+};
+
+/// @brief Sits between every light change and the GPIO. Frames from a controller with a ConflictMatrix are checked
+/// against it along with the pins left lit by everything written before, and the first frame that breaks a rule is
+/// replaced with the matrix's safe state, all red, in the same step. The fault is then latched: every later write is
+/// dropped so the lights stay red until the fault is cleared. A matrix that couldn't hold every rule faults on its first
+/// frame. Frames without a matrix, such as a lamp test, are only tracked. Must only be called from the core running the systems, though the fault can be read from any core.
+class ConflictMonitor
+{
+public:
+    /// @brief Writes the pins unless they break the matrix or a fault is latched.
+    /// @param matrix The rules to check against, or null to write without checking.
+    /// @return False if the write was dropped or replaced.
+    static bool commit(const ConflictMatrix *matrix, uint32_t mask, uint32_t values);
+
+    static ConflictFault getFault();
+
+    /// @brief Gets the pins that were lit when the fault was latched.
+    static uint32_t getFaultPins();
+
+    /// @brief Lets the lights change again. Safe to call from any core.
+    static void clearFault();
+
+private:
+    //Every pin written so far and the values last written to them. Pins never written aren't known, so aren't checked.
+    static uint32_t _pins;
+    static uint32_t _writtenPins;
+
+    static std::atomic<uint8_t> _fault;
+    static std::atomic<uint32_t> _faultPins;
+};
\ No newline at end of file
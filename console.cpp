@@ -0,0 +1,873 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Hardware/hardware.h"
+#include "Systems/runnable_system.h"
+#include "step_scheduler.h"
+#include "frame_pipeline.h"
+#include "system_supervisor.h"
+#include "conflict_monitor.h"
+#include "time_of_day.h"
+#include "config_store.h"
+
+#include "console.h"
+
+namespace
+{
+    //Enough for config light, the longest command.
+    constexpr size_t MaximumArguments = 9;
+    constexpr uint PinCount = 30;
+
+    uint32_t readPins()
+    {
+        uint32_t pins = 0;
+        for (uint pin = 0; pin < PinCount; ++pin) {
+            if (Hardware::gpio().get(pin)) {
+                pins |= 1u << pin;
+            }
+        }
+
+        return pins;
+    }
+
+    bool parseNumber(const char *text, long &value)
+    {
+        if (!text) {
+            return false;
+        }
+
+        char *end = nullptr;
+        value = strtol(text, &end, 10);
+
+        return end != text && *end == '\0';
+    }
+
+    //A pin number, or - for none.
+    bool parsePin(const char *text, uint8_t &pin)
+    {
+        long value = 0;
+        if (text && strcmp(text, "-") == 0) {
+            pin = StoredConfig::NoPin;
+            return true;
+        }
+
+        if (!parseNumber(text, value) || value < 0 || value >= StoredConfig::NoPin) {
+            return false;
+        }
+
+        pin = (uint8_t)value;
+
+        return true;
+    }
+
+    void formatPin(uint8_t pin, char (&text)[4])
+    {
+        if (pin == StoredConfig::NoPin) {
+            strcpy(text, "-");
+        }
+        else {
+            snprintf(text, sizeof(text), "%u", (unsigned)pin);
+        }
+    }
+}
+
+int Console::addSystem(const char *name, std::shared_ptr<RunnableSystem> system, RequestChannel *requests)
+{
+    if (_systemCount >= MaximumSystems) {
+        return NoSystem;
+    }
+
+    auto &entry = _systems[_systemCount];
+    entry.name = name;
+    entry.system = system;
+    entry.requests = requests;
+
+    return (int)_systemCount++;
+}
+
+void Console::setPipeline(std::shared_ptr<FramePipeline> pipeline)
+{
+    _pipeline = pipeline;
+}
+
+void Console::setSupervisor(std::shared_ptr<SystemSupervisor> supervisor)
+{
+    _supervisor = supervisor;
+}
+
+void Console::setConfig(const StoredConfig &config)
+{
+    _config = config;
+    _hasConfig = true;
+}
+
+void Console::setRotationSystems(uint16_t systems)
+{
+    _rotationSystems = systems;
+}
+
+void Console::setParkingSystem(int index, uint32_t mask, uint32_t values)
+{
+    _parkingSystem = index;
+    _parkedMask = mask;
+    _parkedValues = values;
+}
+
+void Console::setActiveSystem(int index)
+{
+    _activeSystem.store(index, std::memory_order_relaxed);
+}
+
+int Console::getRequestedSystem() const
+{
+    return _requestedSystem.load(std::memory_order_relaxed);
+}
+
+void Console::poll()
+{
+    flush();
+    continueTrace();
+    continueConfigListing();
+
+    //Input waits while a trace or the config is being written, so no other reply ends up in the middle of it.
+    for (size_t read = 0; read < MaximumReadPerPoll && !_tracing && !_listingConfig; ++read) {
+        auto character = Hardware::serial().read();
+        if (character == AbstractSerial::NoData) {
+            break;
+        }
+
+        if (character == '\r' || character == '\n') {
+            if (_lineTooLong) {
+                reply("error: line longer than %u characters\n", (unsigned)LineLength);
+            }
+            else if (_lineLength > 0) {
+                _line[_lineLength] = '\0';
+                runCommand(_line);
+            }
+
+            _lineLength = 0;
+            _lineTooLong = false;
+        }
+        else if (_lineLength < LineLength) {
+            _line[_lineLength++] = (char)character;
+        }
+        else {
+            _lineTooLong = true;
+        }
+    }
+
+    flush();
+}
+
+uint32_t Console::getDroppedCount() const
+{
+    return _droppedCount.load(std::memory_order_relaxed);
+}
+
+void Console::runCommand(char *line)
+{
+    const char *arguments[MaximumArguments] = {};
+    size_t argumentCount = 0;
+
+    for (auto *token = line; *token && argumentCount < MaximumArguments;) {
+        while (*token == ' ') {
+            ++token;
+        }
+
+        if (!*token) {
+            break;
+        }
+
+        arguments[argumentCount++] = token;
+
+        while (*token && *token != ' ') {
+            ++token;
+        }
+
+        if (*token) {
+            *token++ = '\0';
+        }
+    }
+
+    if (argumentCount == 0) {
+        return;
+    }
+
+    auto *command = arguments[0];
+
+    if (strcmp(command, "help") == 0) {
+        showHelp();
+    }
+    else if (strcmp(command, "status") == 0) {
+        showStatus();
+    }
+    else if (strcmp(command, "systems") == 0) {
+        showSystems();
+    }
+    else if (strcmp(command, "system") == 0) {
+        selectSystem(arguments[1], arguments[2]);
+    }
+    else if (strcmp(command, "timings") == 0) {
+        showTimings(arguments[1]);
+    }
+    else if (strcmp(command, "set") == 0) {
+        changeTiming(arguments[1], arguments[2], arguments[3]);
+    }
+    else if (strcmp(command, "cross") == 0) {
+        postRequest(RequestEvent::Type::Crossing, nullptr);
+    }
+    else if (strcmp(command, "next") == 0) {
+        postRequest(RequestEvent::Type::NextGroup, nullptr);
+    }
+    else if (strcmp(command, "mode") == 0) {
+        postRequest(RequestEvent::Type::ModeChange, arguments[1]);
+    }
+    else if (strcmp(command, "stats") == 0) {
+        showStats();
+    }
+    else if (strcmp(command, "fault") == 0) {
+        showFault(arguments[1]);
+    }
+    else if (strcmp(command, "time") == 0) {
+        changeTime(arguments[1]);
+    }
+    else if (strcmp(command, "trace") == 0) {
+        startTrace();
+    }
+    else if (strcmp(command, "config") == 0) {
+        changeConfig(arguments + 1, argumentCount - 1);
+    }
+    else if (strcmp(command, "save") == 0) {
+        saveConfig();
+    }
+    else {
+        reply("error: unknown command '%s', try help\n", command);
+    }
+}
+
+void Console::showHelp()
+{
+    reply("status | systems | system <name|auto> [now]\n");
+    reply("timings [group] | set <timing> <ms> [group]\n");
+    reply("cross | next | mode <n> | stats | fault [clear] | time [hh:mm] | trace\n");
+    reply("config | config light <n> <r> <y> <g> <rc|-> <gc|-> <anode|cathode> | config light <n> remove\n");
+    reply("config systems <all|name...> | config timing <system> <timing> <ms|default> [group] | save\n");
+}
+
+void Console::showStatus()
+{
+    auto pins = readPins();
+
+    auto *entry = getActiveEntry();
+    if (!entry) {
+        reply("system none pins 0x%08lx\n", (unsigned long)pins);
+        return;
+    }
+
+    auto status = entry->system->getStatus();
+    reply("system %s phase %s group %d pins 0x%08lx\n", entry->name, entry->system->getPhaseName(status.phase), status.group, (unsigned long)pins);
+}
+
+void Console::showSystems()
+{
+    auto active = _activeSystem.load(std::memory_order_relaxed);
+    auto requested = _requestedSystem.load(std::memory_order_relaxed);
+
+    for (size_t index = 0; index < _systemCount; ++index) {
+        reply("%c %s%s\n", (int)index == active ? '*' : ' ', _systems[index].name, (int)index == requested ? " (requested)" : "");
+    }
+}
+
+void Console::showTimings(const char *group)
+{
+    auto *entry = getActiveEntry();
+    if (!entry) {
+        reply("error: no system running\n");
+        return;
+    }
+
+    long groupId = -1;
+    if (group && !parseNumber(group, groupId)) {
+        reply("error: bad group '%s'\n", group);
+        return;
+    }
+
+    auto &system = *entry->system;
+    auto shown = false;
+    for (size_t timing = 0; timing < system.getTimingCount(); ++timing) {
+        std::chrono::milliseconds time;
+        if (system.readTiming(timing, (int)groupId, time)) {
+            reply("%u %s %lld\n", (unsigned)timing, system.getTimingName(timing), (long long)time.count());
+            shown = true;
+        }
+    }
+
+    if (!shown && group) {
+        reply("error: %s has no timings for group %ld\n", entry->name, groupId);
+    }
+}
+
+void Console::showFault(const char *action)
+{
+    if (action && strcmp(action, "clear") != 0) {
+        reply("error: expected clear, not '%s'\n", action);
+        return;
+    }
+
+    auto fault = ConflictMonitor::getFault();
+    if (fault == ConflictFault::None) {
+        reply("fault none\n");
+        return;
+    }
+
+    if (action) {
+        ConflictMonitor::clearFault();
+        reply("ok, cleared\n");
+        return;
+    }
+
+    const char *name = "";
+    switch (fault) {
+        case ConflictFault::ConflictingGreens:
+            name = "conflicting-greens";
+            break;
+        case ConflictFault::GreenWithCrossing:
+            name = "green-with-crossing";
+            break;
+        case ConflictFault::TooManyRules:
+            name = "too-many-rules";
+            break;
+        case ConflictFault::None:
+            break;
+    }
+
+    reply("fault %s lit 0x%08lx\n", name, (unsigned long)ConflictMonitor::getFaultPins());
+}
+
+void Console::changeTime(const char *time)
+{
+    if (!time) {
+        if (!TimeOfDay::isSet()) {
+            reply("time not set\n");
+            return;
+        }
+
+        auto minutes = TimeOfDay::get().count();
+        reply("time %02d:%02d\n", (int)(minutes / 60), (int)(minutes % 60));
+        return;
+    }
+
+    int hours = 0;
+    int minutes = 0;
+    char end = '\0';
+    if (sscanf(time, "%d:%d%c", &hours, &minutes, &end) != 2 || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+        reply("error: time hh:mm\n");
+        return;
+    }
+
+    TimeOfDay::set(std::chrono::hours(hours) + std::chrono::minutes(minutes));
+    reply("ok, timing plans follow the time of day from the next cycle\n");
+}
+
+void Console::startTrace()
+{
+    if (!TraceRecorder::snapshot(_trace)) {
+        reply("error: trace busy, try again\n");
+        return;
+    }
+
+    _traceLine = 0;
+    _traceBegun = false;
+    _tracing = true;
+
+    continueTrace();
+}
+
+void Console::continueTrace()
+{
+    //The whole trace doesn't fit in the output buffer, so it goes out a line at a time as the buffer drains, in the
+    //same format as TraceRecorder::dump().
+    while (_tracing && OutputCapacity - _outputLength >= MaximumReplyLength) {
+        if (!_traceBegun) {
+            reply(TraceRecorder::BeginFormat, (unsigned int)_trace.count, (long long)_trace.lastTime.count());
+            _traceBegun = true;
+        }
+        else if (_traceLine < _trace.count) {
+            auto &record = _trace.records[_traceLine++];
+            reply(TraceRecorder::RecordFormat, (unsigned long)record.timeDelta, record.groupId, record.lights, (unsigned int)record.cause);
+        }
+        else {
+            reply(TraceRecorder::EndLine);
+            _tracing = false;
+        }
+    }
+}
+
+void Console::showStats()
+{
+    auto &steps = StepScheduler::getLatenessHistogram();
+    reply("step-lateness count %lu mean %lldus max %lldus\n", (unsigned long)steps.count(), (long long)steps.getMean().count(), (long long)steps.getMaximum().count());
+
+    if (_pipeline) {
+        auto &commits = _pipeline->getLatenessHistogram();
+        reply("commit-lateness count %lu mean %lldus max %lldus\n", (unsigned long)commits.count(), (long long)commits.getMean().count(), (long long)commits.getMaximum().count());
+    }
+
+    auto *entry = getActiveEntry();
+    if (entry) {
+        auto &cycles = entry->system->getCycleDurations();
+        reply("cycles count %lu mean %lldms\n", (unsigned long)cycles.count(), (long long)std::chrono::duration_cast<std::chrono::milliseconds>(cycles.getMean()).count());
+    }
+
+    if (_supervisor) {
+        auto &switches = _supervisor->getSwitchLatencies();
+        reply("switch-latency count %lu last %lldus max %lldus\n", (unsigned long)switches.count(), (long long)_supervisor->getLastSwitchLatency().count(), (long long)switches.getMaximum().count());
+    }
+
+    reply("console-dropped %lu\n", (unsigned long)getDroppedCount());
+}
+
+void Console::selectSystem(const char *name, const char *when)
+{
+    if (!name) {
+        reply("error: system needs a name or auto\n");
+        return;
+    }
+
+    if (strcmp(name, "auto") == 0) {
+        _requestedSystem.store(NoSystem, std::memory_order_relaxed);
+        reply("ok\n");
+        return;
+    }
+
+    auto index = findSystem(name);
+    if (index == NoSystem) {
+        reply("error: unknown system '%s'\n", name);
+        return;
+    }
+
+    auto immediate = when && strcmp(when, "now") == 0;
+    if (when && !immediate) {
+        reply("error: expected now, not '%s'\n", when);
+        return;
+    }
+
+    _requestedSystem.store(index, std::memory_order_relaxed);
+
+    if (!_supervisor) {
+        reply("ok, switching at the end of the cycle\n");
+        return;
+    }
+
+    _supervisor->requestSwitch(index, immediate ? SystemSupervisor::Urgency::Immediate : SystemSupervisor::Urgency::AtSafePoint);
+    reply(immediate ? "ok, switching now\n" : "ok, switching at the next safe point\n");
+}
+
+void Console::changeTiming(const char *timing, const char *time, const char *group)
+{
+    auto *entry = getActiveEntry();
+    if (!entry) {
+        reply("error: no system running\n");
+        return;
+    }
+
+    auto &system = *entry->system;
+
+    auto index = findTiming(system, timing);
+
+    long milliseconds = 0;
+    long groupId = -1;
+    if (index < 0 || !parseNumber(time, milliseconds) || milliseconds < 0 || (group && !parseNumber(group, groupId))) {
+        reply("error: set <timing> <ms> [group]\n");
+        return;
+    }
+
+    std::chrono::milliseconds minimum;
+    std::chrono::milliseconds maximum;
+    if (!system.getTimingLimits((size_t)index, minimum, maximum)) {
+        reply("error: %s has no timing %ld\n", entry->name, index);
+        return;
+    }
+
+    if (milliseconds < minimum.count() || milliseconds > maximum.count()) {
+        reply("error: %s takes %lld to %lld ms\n", system.getTimingName((size_t)index), (long long)minimum.count(), (long long)maximum.count());
+        return;
+    }
+
+    if (!system.publishTiming((size_t)index, (int)groupId, std::chrono::milliseconds(milliseconds))) {
+        if (group) {
+            reply("error: %s has no timing %ld for group %ld\n", entry->name, index, groupId);
+        }
+        else {
+            reply("error: %s has no timing %ld\n", entry->name, index);
+        }
+        return;
+    }
+
+    reply("ok, from the next phase\n");
+}
+
+void Console::postRequest(RequestEvent::Type type, const char *value)
+{
+    auto *entry = getActiveEntry();
+    if (!entry || !entry->requests) {
+        reply("error: %s takes no requests\n", entry ? entry->name : "none");
+        return;
+    }
+
+    long number = 0;
+    if (type == RequestEvent::Type::ModeChange && !parseNumber(value, number)) {
+        reply("error: mode <n>\n");
+        return;
+    }
+
+    auto modeCount = entry->system->getModeCount();
+    if (type == RequestEvent::Type::ModeChange && (number < 0 || (size_t)number >= modeCount)) {
+        if (modeCount == 0) {
+            reply("error: %s has no modes\n", entry->name);
+        }
+        else {
+            reply("error: %s has modes 0 to %u\n", entry->name, (unsigned)(modeCount - 1));
+        }
+        return;
+    }
+
+    if (!entry->requests->post(type, (uint32_t)number)) {
+        reply("error: request dropped, %s is busy\n", entry->name);
+        return;
+    }
+
+    reply("ok\n");
+}
+
+void Console::changeConfig(const char *const *arguments, size_t argumentCount)
+{
+    if (!_hasConfig) {
+        reply("error: no stored config\n");
+        return;
+    }
+
+    if (argumentCount == 0) {
+        startConfigListing();
+    }
+    else if (strcmp(arguments[0], "light") == 0) {
+        changeLight(arguments + 1, argumentCount - 1);
+    }
+    else if (strcmp(arguments[0], "systems") == 0) {
+        changeRunSystems(arguments + 1, argumentCount - 1);
+    }
+    else if (strcmp(arguments[0], "timing") == 0) {
+        changeStoredTiming(arguments + 1, argumentCount - 1);
+    }
+    else {
+        reply("error: config [light|systems|timing ...]\n");
+    }
+}
+
+void Console::changeLight(const char *const *arguments, size_t argumentCount)
+{
+    long index = 0;
+    if (argumentCount == 0 || !parseNumber(arguments[0], index) || index < 0 || index > _config.lightCount || index >= (long)StoredConfig::MaximumLights) {
+        reply("error: lights 0 to %u\n", (unsigned)std::min<size_t>(_config.lightCount, StoredConfig::MaximumLights - 1));
+        return;
+    }
+
+    if (argumentCount == 2 && strcmp(arguments[1], "remove") == 0) {
+        if (index >= _config.lightCount) {
+            reply("error: no light %ld\n", index);
+            return;
+        }
+
+        for (auto next = (size_t)index + 1; next < _config.lightCount; ++next) {
+            _config.lights[next - 1] = _config.lights[next];
+        }
+
+        --_config.lightCount;
+        reply("ok, save to keep\n");
+        return;
+    }
+
+    StoredConfig::Light light;
+    auto parsed = argumentCount == 7 && parsePin(arguments[1], light.redPin) && parsePin(arguments[2], light.yellowPin)
+        && parsePin(arguments[3], light.greenPin) && parsePin(arguments[4], light.redCrossingPin) && parsePin(arguments[5], light.greenCrossingPin)
+        && (strcmp(arguments[6], "anode") == 0 || strcmp(arguments[6], "cathode") == 0);
+
+    if (!parsed) {
+        reply("error: config light <n> <r> <y> <g> <rc|-> <gc|-> <anode|cathode>\n");
+        return;
+    }
+
+    light.commonAnode = strcmp(arguments[6], "anode") == 0 ? 1 : 0;
+
+    if (!light.isValid()) {
+        reply("error: pins must be below %u, and - can only leave out the crossing or the vehicle lights\n", (unsigned)StoredConfig::PinCount);
+        return;
+    }
+
+    if (index == _config.lightCount) {
+        _config.addLight(light);
+    }
+    else {
+        _config.lights[index] = light;
+    }
+
+    reply("ok, save to keep\n");
+}
+
+void Console::changeRunSystems(const char *const *arguments, size_t argumentCount)
+{
+    if (argumentCount == 0) {
+        reply("error: config systems <all|name...>\n");
+        return;
+    }
+
+    uint16_t systems = 0;
+    if (argumentCount != 1 || strcmp(arguments[0], "all") != 0) {
+        for (size_t argument = 0; argument < argumentCount; ++argument) {
+            auto index = findSystem(arguments[argument]);
+            if (index == NoSystem) {
+                reply("error: no system '%s'\n", arguments[argument]);
+                return;
+            }
+
+            systems |= (uint16_t)(1u << index);
+        }
+    }
+
+    if (systems != 0 && (systems & _rotationSystems) == 0) {
+        reply("error: none of those systems take turns in the rotation\n");
+        return;
+    }
+
+    _config.systems = systems;
+    reply("ok, save to keep\n");
+}
+
+void Console::changeStoredTiming(const char *const *arguments, size_t argumentCount)
+{
+    if (argumentCount < 3) {
+        reply("error: config timing <system> <timing> <ms|default> [group]\n");
+        return;
+    }
+
+    auto systemIndex = findSystem(arguments[0]);
+    if (systemIndex == NoSystem) {
+        reply("error: no system '%s'\n", arguments[0]);
+        return;
+    }
+
+    auto &entry = _systems[systemIndex];
+    auto timing = findTiming(*entry.system, arguments[1]);
+
+    //Read back only to check the system has the timing and group.
+    long groupId = -1;
+    std::chrono::milliseconds current;
+    if (timing < 0 || (argumentCount > 3 && !parseNumber(arguments[3], groupId)) || !entry.system->readTiming((size_t)timing, (int)groupId, current)) {
+        reply("error: %s has no timing '%s'%s\n", entry.name, arguments[1], argumentCount > 3 ? " for that group" : "");
+        return;
+    }
+
+    if (strcmp(arguments[2], "default") == 0) {
+        _config.removeOverride((uint8_t)systemIndex, (size_t)timing, (int)groupId);
+        reply("ok, save to keep\n");
+        return;
+    }
+
+    long milliseconds = 0;
+    std::chrono::milliseconds minimum;
+    std::chrono::milliseconds maximum;
+    if (!parseNumber(arguments[2], milliseconds) || !entry.system->getTimingLimits((size_t)timing, minimum, maximum)
+        || milliseconds < minimum.count() || milliseconds > maximum.count()) {
+        reply("error: %s takes %lld to %lld ms\n", entry.system->getTimingName((size_t)timing), (long long)minimum.count(), (long long)maximum.count());
+        return;
+    }
+
+    _config.removeOverride((uint8_t)systemIndex, (size_t)timing, (int)groupId);
+    if (!_config.addOverride((uint8_t)systemIndex, (size_t)timing, (int)groupId, std::chrono::milliseconds(milliseconds))) {
+        reply("error: no room for more than %u timings\n", (unsigned)StoredConfig::MaximumOverrides);
+        return;
+    }
+
+    reply("ok, save to keep\n");
+}
+
+void Console::startConfigListing()
+{
+    _configLine = 0;
+    _listingConfig = true;
+
+    continueConfigListing();
+}
+
+void Console::continueConfigListing()
+{
+    //Listed as the commands that would set it up again, a line at a time as the output buffer drains.
+    while (_listingConfig && OutputCapacity - _outputLength >= MaximumReplyLength) {
+        auto lightCount = std::min<size_t>(_config.lightCount, StoredConfig::MaximumLights);
+        auto overrideCount = std::min<size_t>(_config.overrideCount, StoredConfig::MaximumOverrides);
+        auto line = _configLine++;
+
+        if (line < lightCount) {
+            auto &light = _config.lights[line];
+            char pins[5][4];
+            formatPin(light.redPin, pins[0]);
+            formatPin(light.yellowPin, pins[1]);
+            formatPin(light.greenPin, pins[2]);
+            formatPin(light.redCrossingPin, pins[3]);
+            formatPin(light.greenCrossingPin, pins[4]);
+
+            reply("config light %u %s %s %s %s %s %s\n", (unsigned)line, pins[0], pins[1], pins[2], pins[3], pins[4], light.commonAnode ? "anode" : "cathode");
+        }
+        else if (line == lightCount) {
+            if (_config.systems == 0) {
+                reply("config systems all\n");
+                continue;
+            }
+
+            char names[MaximumReplyLength] = {};
+            size_t length = 0;
+            for (size_t index = 0; index < _systemCount; ++index) {
+                if (_config.runsSystem((uint8_t)index) && length < sizeof(names)) {
+                    length += (size_t)snprintf(names + length, sizeof(names) - length, " %s", _systems[index].name);
+                }
+            }
+
+            reply("config systems%s\n", names);
+        }
+        else if (line < lightCount + 1 + overrideCount) {
+            auto &entry = _config.overrides[line - lightCount - 1];
+            auto *name = entry.system < _systemCount ? _systems[entry.system].system->getTimingName(entry.timing) : "";
+
+            if (entry.system >= _systemCount) {
+                reply("config timing %u %u %lu %d\n", (unsigned)entry.system, (unsigned)entry.timing, (unsigned long)entry.milliseconds, (int)entry.group);
+            }
+            else if (*name) {
+                reply("config timing %s %s %lu %d\n", _systems[entry.system].name, name, (unsigned long)entry.milliseconds, (int)entry.group);
+            }
+            else {
+                reply("config timing %s %u %lu %d\n", _systems[entry.system].name, (unsigned)entry.timing, (unsigned long)entry.milliseconds, (int)entry.group);
+            }
+        }
+        else {
+            _listingConfig = false;
+        }
+    }
+}
+
+void Console::saveConfig()
+{
+    if (!_hasConfig) {
+        reply("error: no stored config\n");
+        return;
+    }
+
+    //Writing flash stops both cores, pin writes and all, so it's only done once the lights show red and nothing but the
+    //parking system's red is left to write.
+    if (_parkingSystem == NoSystem || _parkingSystem >= (int)_systemCount) {
+        reply("error: saving stops the lights, and there's no system to hold them on red\n");
+        return;
+    }
+
+    if (_activeSystem.load(std::memory_order_relaxed) != _parkingSystem || (readPins() & _parkedMask) != _parkedValues) {
+        reply("error: saving stops the lights, so only once system %s has them on red\n", _systems[_parkingSystem].name);
+        return;
+    }
+
+    auto startedAt = Hardware::clock().now();
+
+    //The store is scanned afresh, as it's only written from here once the board is running.
+    ConfigStore store;
+    store.load();
+
+    if (!_config.save(store)) {
+        reply("error: couldn't write the config to flash\n");
+        return;
+    }
+
+    auto stalled = std::chrono::duration_cast<std::chrono::milliseconds>(Hardware::clock().now() - startedAt);
+    reply("ok, saved with the lights stopped for %lld ms, used from the next reset\n", (long long)stalled.count());
+}
+
+void Console::reply(const char *format, ...)
+{
+    char text[MaximumReplyLength];
+
+    va_list arguments;
+    va_start(arguments, format);
+    auto length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+
+    if (length < 0) {
+        return;
+    }
+
+    auto size = std::min((size_t)length, sizeof(text) - 1);
+    if (size > OutputCapacity - _outputLength) {
+        _droppedCount.store(_droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    for (size_t index = 0; index < size; ++index) {
+        _output[(_outputStart + _outputLength + index) % OutputCapacity] = text[index];
+    }
+
+    _outputLength += size;
+}
+
+void Console::flush()
+{
+    while (_outputLength > 0) {
+        //Writes up to the end of the buffer first, as the pending output may wrap round.
+        auto contiguous = std::min(_outputLength, OutputCapacity - _outputStart);
+        auto written = Hardware::serial().write(_output + _outputStart, contiguous);
+
+        _outputStart = (_outputStart + written) % OutputCapacity;
+        _outputLength -= written;
+
+        if (written < contiguous) {
+            break;
+        }
+    }
+}
+
+int Console::findSystem(const char *name) const
+{
+    for (size_t index = 0; index < _systemCount; ++index) {
+        if (strcmp(_systems[index].name, name) == 0) {
+            return (int)index;
+        }
+    }
+
+    return NoSystem;
+}
+
+long Console::findTiming(const RunnableSystem &system, const char *timing) const
+{
+    if (!timing) {
+        return -1;
+    }
+
+    //By index or by name.
+    long index = -1;
+    if (parseNumber(timing, index)) {
+        return index;
+    }
+
+    for (size_t candidate = 0; candidate < system.getTimingCount(); ++candidate) {
+        if (strcmp(timing, system.getTimingName(candidate)) == 0) {
+            return (long)candidate;
+        }
+    }
+
+    return -1;
+}
+
+const Console::Entry *Console::getActiveEntry()
+{
+    auto active = _activeSystem.load(std::memory_order_relaxed);
+
+    return active >= 0 && active < (int)_systemCount ? &_systems[active] : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "request_channel.h"
+#include "stored_config.h"
+#include "trace_recorder.h"
+
+class RunnableSystem;
+class FramePipeline;
+class SystemSupervisor;
+
+/// @brief A line based command console over Hardware::serial(), polled from the core that isn't running the lights.
+/// Reading never waits, and replies go through a fixed size buffer that is written out only as fast as the serial backend
+/// takes it, with any reply that doesn't fit dropped, so a slow or missing host can't hold up the caller. Systems are
+/// only driven through their request channels and by publishing timings, never touched directly. The stored set up can
+/// be edited and saved back to flash, to be used from the next reset. Writing flash stops both cores, so saving is only
+/// allowed while the lights are parked on red.
+class Console
+{
+public:
+    static constexpr size_t MaximumSystems = 8;
+    static constexpr size_t LineLength = 64;
+    static constexpr size_t OutputCapacity = 512;
+    static constexpr size_t MaximumReplyLength = 96;
+
+    /// @brief The most characters read in one poll, so a flood of input can't take over the core.
+    static constexpr size_t MaximumReadPerPoll = 32;
+
+    static constexpr int NoSystem = -1;
+
+    /// @brief Registers a system under a name, in the order they're listed. Call before polling starts.
+    /// @param requests The channel the console posts requests to, which nothing else may post to, or null if the system
+    /// takes no requests.
+    /// @return The index of the system, or NoSystem if there are already MaximumSystems.
+    int addSystem(const char *name, std::shared_ptr<RunnableSystem> system, RequestChannel *requests = nullptr);
+
+    /// @brief Reports the frame pipeline in use so its lateness can be shown. Call before polling starts.
+    void setPipeline(std::shared_ptr<FramePipeline> pipeline);
+
+    /// @brief Lets the system command switch systems part way through a cycle. The supervisor must have the same systems
+    /// registered in the same order. Call before polling starts.
+    void setSupervisor(std::shared_ptr<SystemSupervisor> supervisor);
+
+    /// @brief Gives the console the set up read from flash, for the config commands to edit and save to write back.
+    /// Systems are named in it by the index they were added with, so add them in the same order the set up uses. Call
+    /// before polling starts.
+    void setConfig(const StoredConfig &config);
+
+    /// @brief Names the system that holds every light on red, and the pin values it shows. The config can only be saved
+    /// while it runs and the pins show those values, as writing flash stops the lights. Call before polling starts.
+    void setParkingSystem(int index, uint32_t mask, uint32_t values);
+
+    /// @brief Gives the systems the usual rotation runs, one bit each by index. config systems has to keep at least one of
+    /// them, as the rotation would otherwise have nothing to run. Call before polling starts.
+    void setRotationSystems(uint16_t systems);
+
+    /// @brief Reports the system now running. Call from the core running the systems.
+    void setActiveSystem(int index);
+
+    /// @brief The system asked for with the system command, or NoSystem to carry on as normal. Safe to call from any core.
+    int getRequestedSystem() const;
+
+    /// @brief Reads any waiting input, runs complete commands and writes out as much of any reply as the serial backend
+    /// will take. Never waits.
+    void poll();
+
+    /// @brief Gets how many replies have been dropped because the output buffer was full.
+    uint32_t getDroppedCount() const;
+
+private:
+    struct Entry
+    {
+        const char *name = nullptr;
+        std::shared_ptr<RunnableSystem> system;
+        RequestChannel *requests = nullptr;
+    };
+
+    std::array<Entry, MaximumSystems> _systems;
+    size_t _systemCount = 0;
+
+    std::shared_ptr<FramePipeline> _pipeline;
+    std::shared_ptr<SystemSupervisor> _supervisor;
+
+    std::atomic<int> _activeSystem = NoSystem;
+    std::atomic<int> _requestedSystem = NoSystem;
+
+    uint16_t _rotationSystems = UINT16_MAX;
+
+    int _parkingSystem = NoSystem;
+    uint32_t _parkedMask = 0;
+    uint32_t _parkedValues = 0;
+
+    char _line[LineLength + 1] = {};
+    size_t _lineLength = 0;
+    bool _lineTooLong = false;
+
+    char _output[OutputCapacity] = {};
+    size_t _outputStart = 0;
+    size_t _outputLength = 0;
+
+    std::atomic<uint32_t> _droppedCount = 0;
+
+    TraceRecorder::Snapshot _trace;
+    size_t _traceLine = 0;
+    bool _traceBegun = false;
+    bool _tracing = false;
+
+    StoredConfig _config;
+    bool _hasConfig = false;
+    size_t _configLine = 0;
+    bool _listingConfig = false;
+
+    void runCommand(char *line);
+    void showHelp();
+    void showStatus();
+    void showSystems();
+    void showTimings(const char *group);
+    void showStats();
+    void showFault(const char *action);
+    void changeTime(const char *time);
+    void startTrace();
+    void continueTrace();
+    void selectSystem(const char *name, const char *when);
+    void changeTiming(const char *timing, const char *time, const char *group);
+    void changeConfig(const char *const *arguments, size_t argumentCount);
+    void changeLight(const char *const *arguments, size_t argumentCount);
+    void changeRunSystems(const char *const *arguments, size_t argumentCount);
+    void changeStoredTiming(const char *const *arguments, size_t argumentCount);
+    void startConfigListing();
+    void continueConfigListing();
+    void saveConfig();
+    void postRequest(RequestEvent::Type type, const char *value);
+    void reply(const char *format, ...);
+    void flush();
+
+    int findSystem(const char *name) const;
+    long findTiming(const RunnableSystem &system, const char *timing) const;
+    const Entry *getActiveEntry();
+};
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "sequence.h"
 #include "trafficlight_group.h"
 #include "controller.h"
@@ -8,83 +10,99 @@ Controller::Controller()
 
 void Controller::addTrafficLightGroup(std::shared_ptr<TrafficLightGroup> group, unsigned int id)
 {
-    _groups[id] = group;
+    auto &existing = _groups[id];
+    if (existing != group) {
+        existing = group;
+        ++_revision;
+    }
 }
 
 void Controller::addSequence(std::shared_ptr<Sequence> sequence, unsigned int targetGroupId)
 {
-    _sequences.push_back({sequence, targetGroupId});
+    _sequences.push_back({sequence, targetGroupId, SequenceSteps()});
+    ++_revision;
+}
+
+void Controller::addSteps(SequenceSteps steps, unsigned int targetGroupId)
+{
+    _sequences.push_back({nullptr, targetGroupId, steps});
+    ++_revision;
 }
 
 void Controller::clearSequences()
 {
     _sequences.clear();
+    ++_revision;
 }
 
-void Controller::run()
+void Controller::setConflictMatrix(std::shared_ptr<const ConflictMatrix> matrix)
 {
-    if (count() > 0) {
-        do
-        {
-            auto sequence = getCurrentSequence();
-            auto group = getCurrentGroup();
-
-            if (sequence && group) {
-                sequence->restart();
-
-                if (sequence->count() > 0) {                
-                    do {
-                        auto lightsToChange = sequence->getCurrentLight();
-                        auto delay = sequence->getCurrentDelay();
-
-                        group->turnAllLightsOff();
-                        group->turnLightsOn(lightsToChange);
-
-                        sleep_ms(delay.count());
-                    }
-                    while (sequence->next());
-                }
-            }
-        }
-        while (next());
-    }
+    _conflicts = matrix;
+    _timeline.setConflictMatrix(_conflicts.get());
 }
 
-void Controller::reset()
+void Controller::run()
 {
-    _index = 0;
+    start();
+    _timeline.run();
 }
 
-bool Controller::next()
-{    
-    ++_index;
-
-    if (_index >= count()) {
-        reset();
-        return false;
-    }
-
-    return true;
+void Controller::start()
+{
+    compile();
+    _timeline.start();
 }
 
-unsigned int Controller::getCurrentGroupId() const
+bool Controller::advance(std::chrono::milliseconds &delay)
 {
-    return std::get<1>(getCurrent());
+    return _timeline.advance(delay);
 }
 
-size_t Controller::count() const
+TrafficLight::Light Controller::getShownLights() const
 {
-    return _sequences.size();
+    return (TrafficLight::Light)_timeline.getShownLights();
 }
 
-std::tuple<std::shared_ptr<Sequence>, unsigned int> Controller::getCurrent() const
+const CompiledTimeline &Controller::compile()
 {
-    return _sequences[_index];
+    auto revision = getSourceRevision();
+    if (_compiled && revision == _compiledRevision) {
+        return _timeline;
+    }
+
+    _timeline.clear();
+
+    for (auto &sequence : _sequences) {
+        auto group = getGroup(std::get<1>(sequence));
+        if (group) {
+            compileSteps(getSteps(sequence), *group);
+        }
+    }
+
+    _compiled = true;
+    _compiledRevision = revision;
+
+    return _timeline;
 }
 
-std::shared_ptr<Sequence> Controller::getCurrentSequence() const
+uint32_t Controller::getSourceRevision() const
 {
-    return std::get<0>(getCurrent());
+    //Every revision only ever goes up, so their sum changes whenever any one of them does.
+    auto revision = _revision;
+
+    for (auto &group : _groups) {
+        if (group.second) {
+            revision += group.second->getRevision();
+        }
+    }
+
+    for (auto &sequence : _sequences) {
+        if (std::get<0>(sequence)) {
+            revision += std::get<0>(sequence)->getRevision();
+        }
+    }
+
+    return revision;
 }
 
 std::shared_ptr<TrafficLightGroup> Controller::getGroup(size_t id) const
@@ -97,7 +115,45 @@ std::shared_ptr<TrafficLightGroup> Controller::getGroup(size_t id) const
     return nullptr;
 }
 
-std::shared_ptr<TrafficLightGroup> Controller::getCurrentGroup() const
+SequenceSteps Controller::getSteps(const std::tuple<std::shared_ptr<Sequence>, unsigned int, SequenceSteps> &sequence) const
+{
+    auto &owned = std::get<0>(sequence);
+    if (owned) {
+        return owned->getSteps();
+    }
+
+    return std::get<2>(sequence);
+}
+
+void Controller::compileSteps(const SequenceSteps &steps, const TrafficLightGroup &group)
 {
-    return getGroup(getCurrentGroupId());
+    auto bankMask = group.getBankMask();
+    auto invertMask = group.getInvertMask();
+    auto traceId = group.getTraceId();
+
+    for (size_t index = 0; index < steps.count; ++index) {
+        auto &step = steps.steps[index];
+
+        if (step.type == SequenceStep::Type::Lights) {
+            auto values = (group.getPinMask(step.light) ^ invertMask) & bankMask;
+            _timeline.addFrame(step.delay, values, bankMask & ~values, traceId, step.light);
+            continue;
+        }
+
+        //Repeats until a duration are turned into a count here, as the block's time is already known.
+        uint32_t times = step.repeatCount;
+        if (step.blockLength == 0 || step.blockLength > index) {
+            times = 1;
+        }
+        else if (times == 0) {
+            auto blockTime = std::chrono::milliseconds(0);
+            for (size_t block = index - step.blockLength; block < index; ++block) {
+                blockTime += steps.steps[block].delay;
+            }
+
+            times = blockTime.count() > 0 ? (uint32_t)((step.delay.count() + blockTime.count() - 1) / blockTime.count()) : 1;
+        }
+
+        _timeline.addRepeat(step.blockLength, (uint16_t)std::min<uint32_t>(std::max<uint32_t>(times, 1), UINT16_MAX));
+    }
 }
\ No newline at end of file
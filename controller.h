@@ -1,12 +1,19 @@
-
 #pragma once
 
 #include <memory>
 #include <vector>
 #include <map>
+#include <tuple>
+#include <chrono>
+#include <cstdint>
+
+#include "sequence_step.h"
+#include "fixed_sequence.h"
+#include "compiled_timeline.h"
 
 class TrafficLightGroup;
 class Sequence;
+class ConflictMatrix;
 
 class Controller
 {
@@ -15,25 +22,56 @@ public:
 
     void addTrafficLightGroup(std::shared_ptr<TrafficLightGroup> group, unsigned int id);
     void addSequence(std::shared_ptr<Sequence> sequence, unsigned int targetGroupId);
+
+    /// @brief Adds a compile time sequence. The sequence isn't copied, so it must outlive the controller; it is
+    /// intended for sequences declared as static constexpr.
+    template<size_t Capacity>
+    void addSequence(const FixedSequence<Capacity> &sequence, unsigned int targetGroupId)
+    {
+        addSteps(sequence.getSteps(), targetGroupId);
+    }
+
+    void addSteps(SequenceSteps steps, unsigned int targetGroupId);
     void clearSequences();
+
+    /// @brief Sets the rules every step is checked against before it is shown (see ConflictMonitor), or null to not
+    /// check, such as for a lamp test. Controllers of the same system normally share one.
+    void setConflictMatrix(std::shared_ptr<const ConflictMatrix> matrix);
     void run();
 
+    /// @brief Starts stepping through the sequences from the beginning without blocking. See advance().
+    void start();
+
+    /// @brief Shows the lights for the next step and returns how long they should be shown for, leaving the waiting
+    /// to the caller so several controllers can be interleaved.
+    /// @param delay Set to the delay of the step that was shown.
+    /// @return False once every step has been shown.
+    bool advance(std::chrono::milliseconds &delay);
+
+    /// @brief The lights the step last shown by advance() set its group to, or None before the first step.
+    TrafficLight::Light getShownLights() const;
+
+    /// @brief Flattens the groups and sequences into a timeline of pin masks, which is what start() and advance()
+    /// replay. The timeline is kept and only rebuilt once a group, sequence or the controller itself has changed.
+    const CompiledTimeline &compile();
+
 private:
-    size_t _index = 0;
+    uint32_t _revision = 0;
+    uint32_t _compiledRevision = 0;
+    bool _compiled = false;
 
     std::map<unsigned int, std::shared_ptr<TrafficLightGroup>> _groups;
-    std::vector<std::tuple<std::shared_ptr<Sequence>, unsigned int>> _sequences;
+    std::vector<std::tuple<std::shared_ptr<Sequence>, unsigned int, SequenceSteps>> _sequences;
 
-    void reset();
+    CompiledTimeline _timeline;
 
-    bool next();
+    std::shared_ptr<const ConflictMatrix> _conflicts;
 
-    unsigned int getCurrentGroupId() const;
+    uint32_t getSourceRevision() const;
 
-    size_t count() const;
-
-    std::tuple<std::shared_ptr<Sequence>, unsigned int> getCurrent() const;
-    std::shared_ptr<Sequence> getCurrentSequence() const;
     std::shared_ptr<TrafficLightGroup> getGroup(size_t id) const;
-    std::shared_ptr<TrafficLightGroup> getCurrentGroup() const;
+
+    SequenceSteps getSteps(const std::tuple<std::shared_ptr<Sequence>, unsigned int, SequenceSteps> &sequence) const;
+
+    void compileSteps(const SequenceSteps &steps, const TrafficLightGroup &group);
 };
\ No newline at end of file
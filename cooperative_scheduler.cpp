@@ -0,0 +1,132 @@
+#include "Hardware/hardware.h"
+#include "step_scheduler.h"
+#include "heartbeat.h"
+
+#include "cooperative_scheduler.h"
+
+bool CooperativeScheduler::addSystem(std::shared_ptr<RunnableSystem> system)
+{
+    if (!system || _count >= MaximumSystems) {
+        return false;
+    }
+
+    _entries[_count].system = system;
+    _entries[_count].started = false;
+    _entries[_count].awaitingRequest = false;
+    _entries[_count].cycles = 0;
+    ++_count;
+
+    return true;
+}
+
+void CooperativeScheduler::run()
+{
+    runUntil(std::chrono::microseconds::max());
+}
+
+void CooperativeScheduler::runUntil(std::chrono::microseconds time)
+{
+    auto &clock = Hardware::clock();
+
+    while (clock.now() < time) {
+        serviceDueSystems(clock.now());
+
+        std::chrono::microseconds deadline;
+        if (getNextDeadline(deadline)) {
+            Heartbeat::beatBy(deadline < time ? deadline : time);
+            clock.waitForEvent(deadline < time ? deadline : time);
+        }
+        else if (time != std::chrono::microseconds::max()) {
+            Heartbeat::beatBy(time);
+            clock.waitForEvent(time);
+        }
+        else {
+            Heartbeat::beatIdle();
+            clock.waitForEvent();
+        }
+    }
+}
+
+size_t CooperativeScheduler::count() const
+{
+    return _count;
+}
+
+uint32_t CooperativeScheduler::getCycleCount(size_t index) const
+{
+    return index < _count ? _entries[index].cycles : 0;
+}
+
+void CooperativeScheduler::serviceDueSystems(std::chrono::microseconds now)
+{
+    for (size_t index = 0; index < _count; ++index) {
+        auto &entry = _entries[index];
+
+        if (!entry.started || entry.awaitingRequest || entry.deadline <= now) {
+            if (entry.started && !entry.awaitingRequest) {
+                StepScheduler::getLatenessHistogram().record(now - entry.deadline);
+            }
+
+            service(entry, now);
+        }
+    }
+}
+
+void CooperativeScheduler::service(Entry &entry, std::chrono::microseconds now)
+{
+    if (!entry.started) {
+        entry.system->start();
+        entry.started = true;
+        entry.deadline = now;
+        entry.cycleStartedAt = now;
+    }
+
+    // Zero length steps and finished cycles carry straight on, so keep going until the system has something to wait for.
+    while (true) {
+        auto step = entry.system->advance();
+
+        switch (step.type) {
+            case SystemStep::Type::Delay:
+                if (entry.awaitingRequest) {
+                    entry.awaitingRequest = false;
+                    entry.deadline = now;
+                }
+                else if (now - entry.deadline > StepScheduler::MaximumCatchUp) {
+                    //Too far behind to catch up without cutting this step short.
+                    entry.deadline = now;
+                }
+
+                entry.deadline += step.delay;
+
+                if (entry.deadline > now) {
+                    return;
+                }
+                break;
+            case SystemStep::Type::AwaitRequest:
+                entry.awaitingRequest = true;
+                return;
+            case SystemStep::Type::Finished:
+                ++entry.cycles;
+                entry.system->recordCycle(now - entry.cycleStartedAt);
+                entry.cycleStartedAt = now;
+                entry.system->start();
+                break;
+        }
+    }
+}
+
+bool CooperativeScheduler::getNextDeadline(std::chrono::microseconds &deadline) const
+{
+    auto found = false;
+
+    for (size_t index = 0; index < _count; ++index) {
+        auto &entry = _entries[index];
+
+        if (entry.started && !entry.awaitingRequest && (!found || entry.deadline < deadline)) {
+            deadline = entry.deadline;
+            found = true;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Systems/runnable_system.h"
+
+/// @brief Runs several systems on one core at the same time by stepping each of them in turn rather than letting any
+/// one of them block. Every system has its own absolute deadline in a shared timer queue; the core sleeps until the
+/// earliest one, or until a request wakes it for a system waiting on one. Systems must drive disjoint pins. Each
+/// system starts a new cycle as soon as its last one finishes.
+class CooperativeScheduler
+{
+public:
+    static constexpr size_t MaximumSystems = 4;
+
+    bool addSystem(std::shared_ptr<RunnableSystem> system);
+
+    /// @brief Runs the systems forever.
+    void run();
+
+    /// @brief Runs the systems until the clock reaches the given time.
+    void runUntil(std::chrono::microseconds time);
+
+    size_t count() const;
+
+    /// @brief Gets how many cycles the system at the given index has finished.
+    uint32_t getCycleCount(size_t index) const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<RunnableSystem> system;
+        std::chrono::microseconds deadline = std::chrono::microseconds(0);
+        std::chrono::microseconds cycleStartedAt = std::chrono::microseconds(0);
+        bool started = false;
+        bool awaitingRequest = false;
+        uint32_t cycles = 0;
+    };
+
+    std::array<Entry, MaximumSystems> _entries;
+    size_t _count = 0;
+
+    void serviceDueSystems(std::chrono::microseconds now);
+    void service(Entry &entry, std::chrono::microseconds now);
+
+    bool getNextDeadline(std::chrono::microseconds &deadline) const;
+};
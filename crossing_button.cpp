@@ -0,0 +1,57 @@
+#include "Hardware/hardware.h"
+
+#include "crossing_button.h"
+
+CrossingButton::CrossingButton(uint pin, RequestChannel &requests, std::chrono::milliseconds debounceTime) : _pin(pin), _requests(requests), _debounceTime(debounceTime)
+{
+    Hardware::gpio().initInputPin(_pin);
+    _level = Hardware::gpio().get(_pin);
+    Hardware::gpio().setEdgeCallback(_pin, &CrossingButton::onEdge, this);
+}
+
+CrossingButton::~CrossingButton()
+{
+    Hardware::gpio().setEdgeCallback(_pin, nullptr, nullptr);
+}
+
+uint CrossingButton::getPin() const
+{
+    return _pin;
+}
+
+uint32_t CrossingButton::getPressCount() const
+{
+    return _pressCount;
+}
+
+uint32_t CrossingButton::getBounceCount() const
+{
+    return _bounceCount;
+}
+
+void CrossingButton::onEdge(uint pin, bool level, std::chrono::microseconds timestamp, void *context)
+{
+    static_cast<CrossingButton *>(context)->handleEdge(level, timestamp);
+}
+
+void CrossingButton::handleEdge(bool level, std::chrono::microseconds timestamp)
+{
+    //Every edge moves the reference time on, so a press is only taken from a line that has settled low.
+    auto settledLow = !_level && timestamp - _lastEdge >= _debounceTime;
+
+    _level = level;
+    _lastEdge = timestamp;
+
+    if (!level) {
+        return;
+    }
+
+    if (!settledLow) {
+        _bounceCount = _bounceCount + 1;
+        return;
+    }
+
+    _pressCount = _pressCount + 1;
+
+    _requests.post(RequestEvent::Type::Crossing, 0, timestamp);
+}
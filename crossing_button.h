@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+
+#include "Hardware/hardware_types.h"
+#include "request_channel.h"
+
+/// @brief A push button wired to an input pin that posts a crossing request as soon as it is pressed. Edges are picked up
+/// by interrupt and stamped with the hardware timer. A rising edge only counts as a press once the line has stayed low
+/// for the debounce time, so bounce on either pressing or releasing the button is ignored however long it is held. The
+/// interrupt is the only producer for the channel it is given, so the button needs a channel of its own.
+class CrossingButton
+{
+public:
+    CrossingButton(uint pin, RequestChannel &requests, std::chrono::milliseconds debounceTime = std::chrono::milliseconds(50));
+    ~CrossingButton();
+
+    CrossingButton(const CrossingButton &) = delete;
+    CrossingButton &operator=(const CrossingButton &) = delete;
+
+    uint getPin() const;
+    uint32_t getPressCount() const;
+    uint32_t getBounceCount() const;
+
+private:
+    uint _pin = 0;
+
+    RequestChannel &_requests;
+
+    std::chrono::microseconds _debounceTime;
+    std::chrono::microseconds _lastEdge = std::chrono::microseconds(0);
+
+    volatile bool _level = false;
+    volatile uint32_t _pressCount = 0;
+    volatile uint32_t _bounceCount = 0;
+
+    static void onEdge(uint pin, bool level, std::chrono::microseconds timestamp, void *context);
+
+    void handleEdge(bool level, std::chrono::microseconds timestamp);
+};
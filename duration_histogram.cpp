@@ -0,0 +1,118 @@
+#include <cstdio>
+
+#include "duration_histogram.h"
+
+void DurationHistogram::record(std::chrono::microseconds duration)
+{
+    auto count = duration.count();
+    auto microseconds = count < 0 ? 0 : (count > UINT32_MAX ? UINT32_MAX : (uint32_t)count);
+
+    auto &bucket = _buckets[getBucketIndex(microseconds)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (microseconds < _minimum.load(std::memory_order_relaxed)) {
+        _minimum.store(microseconds, std::memory_order_relaxed);
+    }
+
+    if (microseconds > _maximum.load(std::memory_order_relaxed)) {
+        _maximum.store(microseconds, std::memory_order_relaxed);
+    }
+
+    auto recorded = _count.load(std::memory_order_relaxed) + 1;
+    _total += microseconds;
+    _mean.store((uint32_t)(_total / recorded), std::memory_order_relaxed);
+    _count.store(recorded, std::memory_order_relaxed);
+}
+
+void DurationHistogram::clear()
+{
+    for (auto &bucket : _buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+
+    _count.store(0, std::memory_order_relaxed);
+    _minimum.store(UINT32_MAX, std::memory_order_relaxed);
+    _maximum.store(0, std::memory_order_relaxed);
+    _mean.store(0, std::memory_order_relaxed);
+    _total = 0;
+}
+
+uint32_t DurationHistogram::count() const
+{
+    return _count.load(std::memory_order_relaxed);
+}
+
+uint32_t DurationHistogram::getBucket(size_t bucket) const
+{
+    return bucket < BucketCount ? _buckets[bucket].load(std::memory_order_relaxed) : 0;
+}
+
+std::chrono::microseconds DurationHistogram::getBucketLowerBound(size_t bucket)
+{
+    return std::chrono::microseconds(bucket == 0 ? 0 : (1ll << (bucket - 1)));
+}
+
+std::chrono::microseconds DurationHistogram::getBucketUpperBound(size_t bucket)
+{
+    return std::chrono::microseconds(bucket == 0 ? 0 : (1ll << bucket) - 1);
+}
+
+std::chrono::microseconds DurationHistogram::getMinimum() const
+{
+    return std::chrono::microseconds(count() > 0 ? _minimum.load(std::memory_order_relaxed) : 0);
+}
+
+std::chrono::microseconds DurationHistogram::getMaximum() const
+{
+    return std::chrono::microseconds(_maximum.load(std::memory_order_relaxed));
+}
+
+std::chrono::microseconds DurationHistogram::getMean() const
+{
+    return std::chrono::microseconds(_mean.load(std::memory_order_relaxed));
+}
+
+std::chrono::microseconds DurationHistogram::getPercentile(unsigned int percent) const
+{
+    auto target = ((uint64_t)count() * (percent > 100 ? 100 : percent) + 99) / 100;
+    uint64_t seen = 0;
+
+    for (size_t bucket = 0; bucket < BucketCount; ++bucket) {
+        seen += getBucket(bucket);
+
+        if (seen >= target && seen > 0) {
+            auto bound = getBucketUpperBound(bucket);
+            return bound < getMaximum() ? bound : getMaximum();
+        }
+    }
+
+    return getMaximum();
+}
+
+void DurationHistogram::print(const char *name) const
+{
+    printf("%s: %lu recorded, min %lld us, mean %lld us, p99 <= %lld us, max %lld us\n", name,
+        (unsigned long)count(),
+        (long long)getMinimum().count(),
+        (long long)getMean().count(),
+        (long long)getPercentile(99).count(),
+        (long long)getMaximum().count());
+
+    for (size_t bucket = 0; bucket < BucketCount; ++bucket) {
+        if (getBucket(bucket) > 0) {
+            printf("  %10lld - %10lld us: %lu\n", (long long)getBucketLowerBound(bucket).count(), (long long)getBucketUpperBound(bucket).count(), (unsigned long)getBucket(bucket));
+        }
+    }
+}
+
+size_t DurationHistogram::getBucketIndex(uint32_t microseconds)
+{
+    size_t bucket = 0;
+
+    while (microseconds != 0 && bucket < BucketCount - 1) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
\ No newline at end of file
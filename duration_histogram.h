@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Counts durations into fixed power of two buckets of microseconds. Bucket 0 holds zero, and bucket n holds
+/// durations from 2^(n - 1) up to 2^n - 1 microseconds, so the same 32 buckets cover sub-microsecond jitter and phases
+/// lasting over half an hour. Recording takes a few loads and stores and a division, and never allocates. One core records
+/// and clears; another core can read at any time. Every value it reads is a single 32 bit word, so none can be torn,
+/// though they may be briefly out of step with each other.
+class DurationHistogram
+{
+public:
+    static constexpr size_t BucketCount = 32;
+
+    void record(std::chrono::microseconds duration);
+    void clear();
+
+    uint32_t count() const;
+    uint32_t getBucket(size_t bucket) const;
+
+    static std::chrono::microseconds getBucketLowerBound(size_t bucket);
+    static std::chrono::microseconds getBucketUpperBound(size_t bucket);
+
+    std::chrono::microseconds getMinimum() const;
+    std::chrono::microseconds getMaximum() const;
+    std::chrono::microseconds getMean() const;
+
+    /// @brief Gets the upper bound of the bucket the given percentage of durations fall within, or the maximum if lower.
+    std::chrono::microseconds getPercentile(unsigned int percent) const;
+
+    /// @brief Prints a summary line and every bucket in use over stdio.
+    void print(const char *name) const;
+
+private:
+    std::array<std::atomic<uint32_t>, BucketCount> _buckets {};
+    std::atomic<uint32_t> _count { 0 };
+    std::atomic<uint32_t> _minimum { UINT32_MAX };
+    std::atomic<uint32_t> _maximum { 0 };
+    std::atomic<uint32_t> _mean { 0 };
+
+    //Only touched by the recording core, as a 64 bit value can be torn when read from another.
+    uint64_t _total = 0;
+
+    static size_t getBucketIndex(uint32_t microseconds);
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+#include "sequence_step.h"
+
+/// @brief A sequence with a capacity fixed at compile time. Unlike Sequence it can be built entirely in a constexpr
+/// context, so sequences that don't depend on run time timings can be declared as constexpr globals and live in flash
+/// with no construction cost or heap use. See common_fixed_sequences.h for ready made ones.
+template<size_t Capacity>
+class FixedSequence
+{
+public:
+    constexpr FixedSequence()
+    {
+    }
+
+    constexpr FixedSequence &add(TrafficLight::Light light, std::chrono::milliseconds delay)
+    {
+        if (_count < Capacity) {
+            _steps[_count].light = light;
+            _steps[_count].delay = delay;
+            ++_count;
+        }
+
+        return *this;
+    }
+
+    /// @brief Repeats the last blockLength steps so they run the given number of times in total.
+    constexpr FixedSequence &repeat(size_t blockLength, unsigned int times)
+    {
+        if (_count < Capacity) {
+            _steps[_count].type = SequenceStep::Type::Repeat;
+            _steps[_count].blockLength = blockLength;
+            _steps[_count].repeatCount = times;
+            ++_count;
+        }
+
+        return *this;
+    }
+
+    /// @brief Repeats the last blockLength steps until they have run for at least the given duration.
+    constexpr FixedSequence &repeatFor(size_t blockLength, std::chrono::milliseconds duration)
+    {
+        if (_count < Capacity) {
+            _steps[_count].type = SequenceStep::Type::Repeat;
+            _steps[_count].blockLength = blockLength;
+            _steps[_count].delay = duration;
+            ++_count;
+        }
+
+        return *this;
+    }
+
+    /// @brief The number of steps stored, repeats included.
+    constexpr size_t count() const
+    {
+        return _count;
+    }
+
+    /// @brief The number of steps that show lights, leaving out repeats. getLightForIndex() and getDelayForIndex() are
+    /// indexed over these.
+    constexpr size_t lightCount() const
+    {
+        return getSteps().countLightSteps();
+    }
+
+    constexpr size_t capacity() const
+    {
+        return Capacity;
+    }
+
+    constexpr TrafficLight::Light getLightForIndex(size_t index) const
+    {
+        auto step = getSteps().findLightStep(index);
+        return step ? step->light : TrafficLight::Light::None;
+    }
+
+    constexpr std::chrono::milliseconds getDelayForIndex(size_t index) const
+    {
+        auto step = getSteps().findLightStep(index);
+        return step ? step->delay : std::chrono::milliseconds(0);
+    }
+
+    constexpr SequenceSteps getSteps() const
+    {
+        return { _steps, _count };
+    }
+
+private:
+    SequenceStep _steps[Capacity] = {};
+    size_t _count = 0;
+};
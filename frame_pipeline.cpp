@@ -0,0 +1,197 @@
+#include "step_scheduler.h"
+
+#include "frame_pipeline.h"
+
+namespace
+{
+    class PlannerGpio : public AbstractGpio
+    {
+    public:
+        PlannerGpio(FramePipeline &pipeline, std::shared_ptr<AbstractGpio> gpio) : _pipeline(pipeline), _gpio(gpio) {}
+
+        void initOutputPin(uint pin) override
+        {
+            _gpio->initOutputPin(pin);
+        }
+
+        void initOutputPins(uint32_t mask, uint32_t values) override
+        {
+            _gpio->initOutputPins(mask, values);
+        }
+
+        void initInputPin(uint pin) override
+        {
+            _gpio->initInputPin(pin);
+        }
+
+        void put(uint pin, bool value) override
+        {
+            _pipeline.submit(1u << pin, value ? (1u << pin) : 0);
+        }
+
+        void putMasked(uint32_t mask, uint32_t values) override
+        {
+            _pipeline.submit(mask, values);
+        }
+
+        void setEdgeCallback(uint pin, EdgeCallback callback, void *context) override
+        {
+            _gpio->setEdgeCallback(pin, callback, context);
+        }
+
+        bool get(uint pin) const override
+        {
+            return _gpio->get(pin);
+        }
+
+    private:
+        FramePipeline &_pipeline;
+        std::shared_ptr<AbstractGpio> _gpio;
+    };
+
+    class PlannerClock : public AbstractClock
+    {
+    public:
+        PlannerClock(std::shared_ptr<AbstractClock> clock, std::chrono::microseconds lookahead) : _clock(clock), _lookahead(lookahead) {}
+
+        void sleepFor(std::chrono::milliseconds delay) override
+        {
+            _clock->sleepFor(delay);
+        }
+
+        void sleepUntil(std::chrono::microseconds time) override
+        {
+            _clock->sleepUntil(time - _lookahead);
+        }
+
+        bool waitForEvent(std::chrono::microseconds deadline) override
+        {
+            return _clock->waitForEvent(deadline == std::chrono::microseconds::max() ? deadline : deadline - _lookahead);
+        }
+
+        void notifyEvent() override
+        {
+            _clock->notifyEvent();
+        }
+
+        std::chrono::microseconds now() const override
+        {
+            return _clock->now() + _lookahead;
+        }
+
+    private:
+        std::shared_ptr<AbstractClock> _clock;
+        std::chrono::microseconds _lookahead;
+    };
+}
+
+FramePipeline::FramePipeline(std::shared_ptr<AbstractGpio> gpio, std::shared_ptr<AbstractClock> clock, std::chrono::microseconds lookahead) :
+    _gpio(gpio),
+    _clock(clock),
+    _executorClock(clock),
+    _lookahead(lookahead)
+{
+    _plannerGpio = std::make_shared<PlannerGpio>(*this, gpio);
+    _plannerClock = std::make_shared<PlannerClock>(clock, lookahead);
+}
+
+std::shared_ptr<AbstractGpio> FramePipeline::getPlannerGpio() const
+{
+    return _plannerGpio;
+}
+
+std::shared_ptr<AbstractClock> FramePipeline::getPlannerClock() const
+{
+    return _plannerClock;
+}
+
+void FramePipeline::setExecutorClock(std::shared_ptr<AbstractClock> clock)
+{
+    _executorClock = clock;
+}
+
+void FramePipeline::submit(uint32_t mask, uint32_t values)
+{
+    //Writes made outside of a step, such as while waiting for a request, are due straight away.
+    auto deadline = StepScheduler::getDeadline();
+    if (deadline < _lastDeadline) {
+        deadline = _lastDeadline;
+    }
+
+    _lastDeadline = deadline;
+
+    OutputFrame frame;
+    frame.deadline = deadline;
+    frame.mask = mask;
+    frame.values = values;
+
+    while (!_frames.push(frame)) {
+        _clock->waitForEvent();
+    }
+
+    _clock->notifyEvent();
+}
+
+bool FramePipeline::executeNext()
+{
+    OutputFrame frame;
+
+    if (!_frames.pop(frame)) {
+        return false;
+    }
+
+    _executorClock->sleepUntil(frame.deadline);
+    _gpio->putMasked(frame.mask, frame.values);
+
+    _lateness.record(_executorClock->now() - frame.deadline);
+
+    _executedCount.store(_executedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    //Wakes the planner in case it was waiting for room.
+    _clock->notifyEvent();
+
+    return true;
+}
+
+void FramePipeline::runExecutor()
+{
+    while (true) {
+        if (!executeNext()) {
+            _executorClock->waitForEvent();
+        }
+    }
+}
+
+void FramePipeline::executeUntil(std::chrono::microseconds time)
+{
+    OutputFrame frame;
+
+    while (_frames.peek(frame) && frame.deadline < time) {
+        executeNext();
+    }
+
+    //Anything still queued is due after time, so there is nothing to miss by waiting until then.
+    if (_executorClock->now() < time) {
+        _executorClock->waitForEvent(time);
+    }
+}
+
+std::chrono::microseconds FramePipeline::getLookahead() const
+{
+    return _lookahead;
+}
+
+uint32_t FramePipeline::getExecutedCount() const
+{
+    return _executedCount.load(std::memory_order_relaxed);
+}
+
+std::chrono::microseconds FramePipeline::getMaximumLateness() const
+{
+    return _lateness.getMaximum();
+}
+
+const DurationHistogram &FramePipeline::getLatenessHistogram() const
+{
+    return _lateness;
+}
\ No newline at end of file
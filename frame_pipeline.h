@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "Hardware/abstract_gpio.h"
+#include "Hardware/abstract_clock.h"
+#include "spsc_queue.h"
+#include "duration_histogram.h"
+
+/// @brief A pin write planned for an absolute time.
+struct OutputFrame
+{
+    std::chrono::microseconds deadline = std::chrono::microseconds(0);
+    uint32_t mask = 0;
+    uint32_t values = 0;
+};
+
+/// @brief Splits the lights between a planner and an executor on different cores. The planner runs the systems as
+/// normal with the planner GPIO and clock installed in Hardware. Its writes are stamped with their step's deadline and
+/// queued instead of being made, and its clock runs lookahead ahead of the real one so frames are queued before they're
+/// due. The executor takes the frames in order and makes each write at its deadline, so light changes don't move with
+/// however long the planning took. The planner blocks while the ring is full.
+class FramePipeline
+{
+public:
+    static constexpr size_t Capacity = 32;
+
+    FramePipeline(std::shared_ptr<AbstractGpio> gpio, std::shared_ptr<AbstractClock> clock, std::chrono::microseconds lookahead = std::chrono::milliseconds(20));
+
+    /// @brief The GPIO backend for the planning core, which queues writes and passes everything else straight through.
+    std::shared_ptr<AbstractGpio> getPlannerGpio() const;
+
+    /// @brief The clock for the planning core, running lookahead ahead of the real clock.
+    std::shared_ptr<AbstractClock> getPlannerClock() const;
+
+    /// @brief Uses a different clock to time the writes. Only needed in simulations, where the planner's virtual clock
+    /// can't also be slept on by the executor.
+    void setExecutorClock(std::shared_ptr<AbstractClock> clock);
+
+    /// @brief Planner side. Queues a write, waiting for room if the ring is full, and wakes the executor.
+    void submit(uint32_t mask, uint32_t values);
+
+    /// @brief Executor side. Makes the next queued write at its deadline.
+    /// @return False if nothing was queued.
+    bool executeNext();
+
+    /// @brief Executor side. Makes queued writes forever, sleeping until the planner queues more when there are none.
+    void runExecutor();
+
+    /// @brief Executor side. Makes the queued writes due before time, then waits for the planner or time, whichever
+    /// comes first. Lets the executor core do other short jobs between calls without delaying any write.
+    void executeUntil(std::chrono::microseconds time);
+
+    std::chrono::microseconds getLookahead() const;
+
+    uint32_t getExecutedCount() const;
+
+    /// @brief Gets the latest any write has been made compared to its deadline.
+    std::chrono::microseconds getMaximumLateness() const;
+
+    /// @brief Gets how late every write was made compared to its deadline.
+    const DurationHistogram &getLatenessHistogram() const;
+
+private:
+    SpscQueue<OutputFrame, Capacity> _frames;
+
+    std::shared_ptr<AbstractGpio> _gpio;
+    std::shared_ptr<AbstractClock> _clock;
+    std::shared_ptr<AbstractClock> _executorClock;
+    std::shared_ptr<AbstractGpio> _plannerGpio;
+    std::shared_ptr<AbstractClock> _plannerClock;
+
+    std::chrono::microseconds _lookahead;
+    std::chrono::microseconds _lastDeadline = std::chrono::microseconds(0);
+
+    std::atomic<uint32_t> _executedCount = 0;
+    DurationHistogram _lateness;
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "Hardware/hardware.h"
+
+#include "heartbeat.h"
+
+std::atomic<uint32_t> Heartbeat::_expectedBy = 0;
+std::atomic<bool> Heartbeat::_idle = true;
+
+void Heartbeat::start()
+{
+    beat();
+    Hardware::watchdog().enable(WatchdogTimeout);
+}
+
+void Heartbeat::beat()
+{
+    beatBy(Hardware::clock().now());
+}
+
+void Heartbeat::beatBy(std::chrono::microseconds time)
+{
+    //Released along with the flag so a core that sees the flag clear also sees the time it was cleared with.
+    _expectedBy.store((uint32_t)time.count(), std::memory_order_relaxed);
+    _idle.store(false, std::memory_order_release);
+}
+
+void Heartbeat::beatIdle()
+{
+    _idle.store(true, std::memory_order_release);
+}
+
+bool Heartbeat::service()
+{
+    if (isOverdue()) {
+        return false;
+    }
+
+    Hardware::watchdog().kick();
+
+    return true;
+}
+
+bool Heartbeat::isOverdue()
+{
+    if (_idle.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    auto now = (uint32_t)Hardware::clock().now().count();
+    auto late = (int32_t)(now - _expectedBy.load(std::memory_order_relaxed));
+
+    return late > (int32_t)std::chrono::duration_cast<std::chrono::microseconds>(Grace).count();
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// @brief Keeps the hardware watchdog kicked only while both cores are making progress. The core running the systems
+/// beats at every step, saying when it expects to beat again, or that it is waiting for a request with no deadline. The
+/// other core calls service() from its loop, which kicks the watchdog unless the first core is overdue, so a stall on
+/// either core resets the board. Beats and service() are a few loads and stores.
+class Heartbeat
+{
+public:
+    static constexpr std::chrono::milliseconds WatchdogTimeout = std::chrono::milliseconds(1000);
+
+    /// @brief How long after it said it would beat the core running the systems is taken to have stalled.
+    static constexpr std::chrono::milliseconds Grace = std::chrono::milliseconds(200);
+
+    /// @brief Enables the watchdog. Call from the core that calls service(), once it is about to start its loop.
+    static void start();
+
+    /// @brief Beats now, expecting to beat again within Grace. Call from the core running the systems.
+    static void beat();
+
+    /// @brief Beats now, expecting to beat again by the given time, such as the end of the step about to be waited for.
+    static void beatBy(std::chrono::microseconds time);
+
+    /// @brief Beats now, saying the core is about to wait for a request with no deadline, which can't stall.
+    static void beatIdle();
+
+    /// @brief Kicks the watchdog unless the core running the systems is overdue. Call from the other core's loop, at least
+    /// a few times every WatchdogTimeout.
+    /// @return False if the watchdog wasn't kicked.
+    static bool service();
+
+    /// @brief Whether the core running the systems is overdue. Safe to call from any core.
+    static bool isOverdue();
+
+private:
+    //In microseconds, truncated to 32 bits so they can be stored in one go. Differences survive the wrap every 71 minutes.
+    static std::atomic<uint32_t> _expectedBy;
+    static std::atomic<bool> _idle;
+};
\ No newline at end of file
@@ -1,120 +1,375 @@
 #include <chrono>
+#include <cstdio>
 #include <memory>
 
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
+#include "hardware/sync.h"
 
 #include "Systems/sequenced_interruptable_system.h"
 #include "Systems/single_interruptable_crossing_system.h"
 #include "Systems/na_stop_give_way_system.h"
 #include "Systems/light_test_system.h"
+#include "Systems/all_red_system.h"
+#include "Systems/flashing_red_system.h"
+
+#include "Hardware/hardware.h"
+#include "Hardware/pico_gpio.h"
+#include "Hardware/pico_clock.h"
 
 #include "trafficlight.h"
+#include "trafficlight_group.h"
+#include "boot_pins.h"
+#include "step_scheduler.h"
+#include "frame_pipeline.h"
+#include "system_supervisor.h"
+#include "heartbeat.h"
+#include "safe_mode.h"
+#include "console.h"
+#include "config_store.h"
+#include "stored_config.h"
+
+static constexpr uint CrossingButtonPin = 13;
+static constexpr size_t ConsoleRequestChannel = 1;
+static constexpr std::chrono::milliseconds ConsolePollInterval(5);
+
+enum class SystemSlot { Test, Sequenced, FlashingCrossing, StandardCrossing, StopGiveWay, AllRed };
+
+// The lights are already on red from reset, so the light test between systems is only there to check the lamps.
+#ifdef TRAFFICLIGHT_LAMP_TEST
+static constexpr SystemSlot Rotation[] = {
+    SystemSlot::Test, SystemSlot::Sequenced, SystemSlot::Sequenced,
+    SystemSlot::Test, SystemSlot::FlashingCrossing,
+    SystemSlot::Test, SystemSlot::StandardCrossing,
+    SystemSlot::Test, SystemSlot::StopGiveWay
+};
+#else
+static constexpr SystemSlot Rotation[] = {
+    SystemSlot::Sequenced, SystemSlot::Sequenced, SystemSlot::FlashingCrossing, SystemSlot::StandardCrossing, SystemSlot::StopGiveWay
+};
+#endif
+
+constexpr uint16_t findRotationSystems()
+{
+    uint16_t systems = 0;
+    for (auto slot : Rotation) {
+        systems |= (uint16_t)(1u << (int)slot);
+    }
+
+    return systems;
+}
+
+static constexpr uint16_t RotationSystems = findRotationSystems();
+
+static constexpr StoredConfig::Light DefaultLights[] = {
+    { 0, 1, 2, 3, 4, 1 }, //North: red, yellow, green, red crossing, green crossing, common anode.
+    { 5, 6, 7, 8, 9, 1 }  //South.
+};
+
+static constexpr BootPins EarlyBootPins = BootPins::fromLights(DefaultLights);
 
 std::shared_ptr<SequencedInterruptableSystem> _standardSystem;
 std::shared_ptr<SingleInterruptableCrossingSystem> _flashingCrossingSystem, _standardCrossingSystem;
 std::shared_ptr<NAStopGiveWaySystem> _stopGiveWaySystem;
 std::shared_ptr<LightTestSystem> _lightTestSystem;
+std::shared_ptr<AllRedSystem> _allRedSystem;
+std::shared_ptr<SystemSupervisor> _supervisor = std::make_shared<SystemSupervisor>();
+std::shared_ptr<FramePipeline> _pipeline;
+std::shared_ptr<PicoClock> _clock = std::make_shared<PicoClock>();
+std::shared_ptr<Console> _console = std::make_shared<Console>();
+StoredConfig _config;
 
-void runSequencedSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+// Runs from the .preinit_array, once the SDK has taken the GPIO banks out of reset but before the heap or any static
+// constructor is set up, so the built in lights show red within microseconds of a reset rather than floating until
+// they are constructed and the first system runs.
+static void driveLightsSafe()
 {
-    if (!_standardSystem) {
-        _standardSystem = std::make_shared<SequencedInterruptableSystem>(trafficLights, SequencedInterruptableSystem::SequenceType::Auto);
-        _standardSystem->setTiming(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(6), 0);
-        _standardSystem->setTiming(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(2), 1);
-        _standardSystem->setTiming(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(6), 0);
-        _standardSystem->setTiming(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(3), 1);
+    PicoGpio gpio;
+    gpio.initOutputPins(EarlyBootPins.mask, EarlyBootPins.safeValues);
+}
+
+__attribute__((section(".preinit_array"), used)) static void (*const _driveLightsSafe)() = &driveLightsSafe;
+
+StoredConfig createDefaultConfig()
+{
+    StoredConfig config;
+
+    for (auto &light : DefaultLights) {
+        config.addLight(light);
     }
 
-    _standardSystem->requestCrossing();
-    _standardSystem->run();
+    return config;
 }
 
-void runFlashingCrossingSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+void loadConfig()
 {
-    if (!_flashingCrossingSystem) {
-        _flashingCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+    ConfigStore store;
+    store.load();
+
+    // On first boot, after the layout has changed or if a stored pin isn't on the board, the built in set up is stored so
+    // it can be changed in flash.
+    if (!_config.load(store)) {
+        _config = createDefaultConfig();
+        _config.save(store);
     }
+}
 
-    _flashingCrossingSystem->requestCrossing();
-    _flashingCrossingSystem->run();
+void releaseUnusedBootPins()
+{
+    // Pins driven at reset that the stored set up doesn't use are let go again.
+    auto used = BootPins::fromLights(_config.lights, _config.lightCount < StoredConfig::MaximumLights ? _config.lightCount : StoredConfig::MaximumLights);
+    auto unused = EarlyBootPins.mask & ~used.mask;
+
+    for (uint pin = 0; pin < 32; ++pin) {
+        if ((unused & (1u << pin)) != 0) {
+            Hardware::gpio().initInputPin(pin);
+        }
+    }
 }
 
-void runStandardCrossingSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+std::shared_ptr<TrafficLight> createTrafficLight(const StoredConfig::Light &light)
 {
-    if (!_standardCrossingSystem) {
-        _standardCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Standard);
+    auto ledType = light.commonAnode ? TrafficLight::LedType::CommonAnode : TrafficLight::LedType::CommonCathode;
+
+    if (light.redPin == StoredConfig::NoPin) {
+        return std::make_shared<TrafficLight>((uint)light.redCrossingPin, (uint)light.greenCrossingPin, ledType);
     }
 
-    _standardCrossingSystem->requestCrossing();
-    _standardCrossingSystem->run();
+    if (light.redCrossingPin == StoredConfig::NoPin) {
+        return std::make_shared<TrafficLight>((uint)light.redPin, (uint)light.yellowPin, (uint)light.greenPin, ledType);
+    }
+
+    return std::make_shared<TrafficLight>((uint)light.redPin, (uint)light.yellowPin, (uint)light.greenPin, (uint)light.redCrossingPin, (uint)light.greenCrossingPin, ledType);
+}
+
+template<typename System>
+void applyStoredTimings(System &system, SystemSlot slot)
+{
+    auto timings = system.getStandardTimingProfile();
+    _config.applyTimings((uint8_t)slot, timings);
+    system.publishTimings(timings);
+}
+
+std::shared_ptr<SequencedInterruptableSystem::Schedule> createSequencedSchedule(SequencedInterruptableSystem &system)
+{
+    auto schedule = std::make_shared<SequencedInterruptableSystem::Schedule>();
+
+    auto offPeak = system.getStandardTimingProfile();
+    offPeak.set(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(6), 0);
+    offPeak.set(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(2), 1);
+    offPeak.set(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(6), 0);
+    offPeak.set(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(3), 1);
+
+    auto peak = offPeak;
+    peak.set(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(12), 0);
+    peak.set(SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, std::chrono::seconds(4), 1);
+
+    _config.applyTimings((uint8_t)SystemSlot::Sequenced, offPeak);
+    _config.applyTimings((uint8_t)SystemSlot::Sequenced, peak);
+
+    schedule->addPlan("off-peak", offPeak);
+    schedule->addPlan("peak", peak);
+
+    // The board has no clock that keeps time, so the plans only take over once the time is set with the console's time
+    // command. Until then the off-peak timings are used, along with any stored changes to them.
+    system.publishTimings(offPeak);
+
+    schedule->addSwitch(std::chrono::hours(7), "peak");
+    schedule->addSwitch(std::chrono::hours(10), "off-peak");
+    schedule->addSwitch(std::chrono::hours(16), "peak");
+    schedule->addSwitch(std::chrono::hours(19), "off-peak");
+
+    return schedule;
 }
 
-void runNAStopGiveWaySystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+std::vector<std::shared_ptr<TrafficLight>> createTrafficLights()
 {
-    if (!_stopGiveWaySystem) {
-        _stopGiveWaySystem = std::make_shared<NAStopGiveWaySystem>(trafficLights, 1u);
+    std::vector<std::shared_ptr<TrafficLight>> trafficLights;
+    for (size_t light = 0; light < _config.lightCount && light < StoredConfig::MaximumLights; ++light) {
+        trafficLights.push_back(createTrafficLight(_config.lights[light]));
     }
 
-    _stopGiveWaySystem->run();
+    return trafficLights;
 }
 
-void runTestSystem(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+void setUpSystems()
 {
-    if (!_lightTestSystem) {
-        _lightTestSystem = std::make_shared<LightTestSystem>(trafficLights);
+    auto trafficLights = createTrafficLights();
+
+    _lightTestSystem = std::make_shared<LightTestSystem>(trafficLights);
+
+    _standardSystem = std::make_shared<SequencedInterruptableSystem>(trafficLights, SequencedInterruptableSystem::SequenceType::Auto);
+    _standardSystem->setTimingSchedule(createSequencedSchedule(*_standardSystem));
+    _standardSystem->setCrossingButtonPin(CrossingButtonPin);
+
+    _flashingCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+    _standardCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Standard);
+    _stopGiveWaySystem = std::make_shared<NAStopGiveWaySystem>(trafficLights, 1u);
+    _allRedSystem = std::make_shared<AllRedSystem>(trafficLights);
+
+    applyStoredTimings(*_lightTestSystem, SystemSlot::Test);
+    applyStoredTimings(*_flashingCrossingSystem, SystemSlot::FlashingCrossing);
+    applyStoredTimings(*_standardCrossingSystem, SystemSlot::StandardCrossing);
+    applyStoredTimings(*_stopGiveWaySystem, SystemSlot::StopGiveWay);
+    applyStoredTimings(*_allRedSystem, SystemSlot::AllRed);
+
+    // Registered in the same order as SystemSlot.
+    _console->addSystem("test", _lightTestSystem);
+    _console->addSystem("sequenced", _standardSystem, &_standardSystem->getRequestChannel(ConsoleRequestChannel));
+    _console->addSystem("flashing-crossing", _flashingCrossingSystem, &_flashingCrossingSystem->getRequestChannel(ConsoleRequestChannel));
+    _console->addSystem("crossing", _standardCrossingSystem, &_standardCrossingSystem->getRequestChannel(ConsoleRequestChannel));
+    _console->addSystem("stop-give-way", _stopGiveWaySystem);
+    _console->addSystem("all-red", _allRedSystem);
+
+    _supervisor->addSystem(_lightTestSystem);
+    _supervisor->addSystem(_standardSystem);
+    _supervisor->addSystem(_flashingCrossingSystem);
+    _supervisor->addSystem(_standardCrossingSystem);
+    _supervisor->addSystem(_stopGiveWaySystem);
+    _supervisor->addSystem(_allRedSystem);
+    _console->setSupervisor(_supervisor);
+    _console->setConfig(_config);
+    _console->setRotationSystems(RotationSystems);
+
+    // Saving the config stops both cores while flash is written, so it's only allowed once all-red has every light on red.
+    TrafficLightGroup lights(trafficLights);
+    auto red = lights.getPinMask((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+    _console->setParkingSystem((int)SystemSlot::AllRed, lights.getBankMask(), (red ^ lights.getInvertMask()) & lights.getBankMask());
+}
+
+bool runsInRotation(SystemSlot slot)
+{
+    // A stored choice of only systems the rotation never runs would leave the lights dark, so every system runs instead.
+    return (_config.systems & RotationSystems) == 0 || _config.runsSystem((uint8_t)slot);
+}
+
+int runSystem(SystemSlot slot, int switchTo)
+{
+    // A system switched to takes over straight from the last one, lights and all, rather than going through a light
+    // test. Otherwise a system picked from the console takes the place of the usual rotation until the console switches
+    // back to auto.
+    auto requested = _console->getRequestedSystem();
+    if (switchTo != SystemSupervisor::NoSystem) {
+        slot = (SystemSlot)switchTo;
+    }
+    else if (requested != Console::NoSystem) {
+        slot = (SystemSlot)requested;
+    }
+    else if (!runsInRotation(slot)) {
+        return SystemSupervisor::NoSystem;
     }
 
-    _lightTestSystem->run();
+    _console->setActiveSystem((int)slot);
+
+    switch (slot) {
+        case SystemSlot::Sequenced:
+            _standardSystem->requestCrossing();
+            break;
+        case SystemSlot::FlashingCrossing:
+            _flashingCrossingSystem->requestCrossing();
+            break;
+        case SystemSlot::StandardCrossing:
+            _standardCrossingSystem->requestCrossing();
+            break;
+        case SystemSlot::Test:
+        case SystemSlot::StopGiveWay:
+        case SystemSlot::AllRed:
+            break;
+    }
+
+    return _supervisor->runCycle((int)slot);
 }
 
 void lightsThread()
 {
-    auto northTrafficLight = std::make_shared<TrafficLight>(0u, 1u, 2u, 3u, 4u, TrafficLight::LedType::CommonAnode);
-    auto southTrafficLight = std::make_shared<TrafficLight>(5u, 6u, 7u, 8u, 9u, TrafficLight::LedType::CommonAnode);
-    
-    std::vector<std::shared_ptr<TrafficLight>> trafficLights = { northTrafficLight, southTrafficLight };
+    auto switchTo = SystemSupervisor::NoSystem;
 
     while(true) {
-        runTestSystem(trafficLights);
-        for (auto loops = 2; loops > 0; --loops) {
-            runSequencedSystem(trafficLights);
+        for (auto slot : Rotation) {
+            // A switch part way through a cycle runs the new system before the rotation carries on.
+            do {
+                switchTo = runSystem(slot, switchTo);
+            } while (switchTo != SystemSupervisor::NoSystem);
         }
-        runTestSystem(trafficLights);
-        runFlashingCrossingSystem(trafficLights);
-        runTestSystem(trafficLights);
-        runStandardCrossingSystem(trafficLights);
-        runTestSystem(trafficLights);
-        runNAStopGiveWaySystem(trafficLights);
     }
 }
 
-void initPin(uint pinId, int direction = GPIO_OUT) {
-    gpio_init(pinId);
-    gpio_set_dir(pinId, GPIO_OUT);
+void runSafeMode()
+{
+    Hardware::setClock(_clock);
+
+    // The config is only read, as writing to flash would hold up the lights. A config with pins the board doesn't have
+    // isn't loaded, so the lights are always built from pins that exist.
+    ConfigStore store;
+    store.load();
+
+    if (!_config.load(store)) {
+        _config = createDefaultConfig();
+    }
+
+    SafeMode safeMode(std::make_shared<FlashingRedSystem>(createTrafficLights()));
+    safeMode.enter();
+
+    stdio_init_all();
+    printf("watchdog reset, flashing red %lld us after reset\n", (long long)safeMode.getResetToSafeTime().count());
+
+    safeMode.run();
 }
 
 void inputsThread()
 {
-    initPin(13, GPIO_IN);
-    initPin(PICO_DEFAULT_LED_PIN);
-    
-    while (true) {   
-        if (gpio_get(13)) {
-            if (_standardSystem) {
-                _standardSystem->requestCrossing();
-                //_standardSystem->requestNextGroup();
-            }
-
-            sleep_ms(1000);
+    Hardware::gpio().initOutputPin(PICO_DEFAULT_LED_PIN);
+    Heartbeat::start();
+
+    // Crossing buttons are handled by interrupt, so this core is free to make the pin writes planned by core 0 and to
+    // serve the console in between them. Neither ever waits on the USB host. The watchdog is only kicked from here while
+    // core 0 keeps to its schedule, so a stall on either core resets the board into safe mode.
+    while (true) {
+        Heartbeat::service();
+        _console->poll();
+
+        auto until = _clock->now() + ConsolePollInterval;
+        if (_pipeline) {
+            _pipeline->executeUntil(until);
+        }
+        else {
+            _clock->waitForEvent(until);
         }
-        
-        sleep_ms(100);
     }
 }
 
 int main() 
 {
+    // After a stall the lights go straight to safe mode, before anything else is set up, and stay there until the board
+    // is reset by hand.
+    if (Hardware::watchdog().causedReboot()) {
+        runSafeMode();
+    }
+
+    stdio_init_all();
+
+#ifdef TRAFFICLIGHT_PIPELINE
+    _pipeline = std::make_shared<FramePipeline>(std::make_shared<PicoGpio>(), _clock);
+    Hardware::setGpio(_pipeline->getPlannerGpio());
+    Hardware::setClock(_pipeline->getPlannerClock());
+    _console->setPipeline(_pipeline);
+#else
+    Hardware::setClock(_clock);
+#endif
+
+    Hardware::setUpDefaults();
+
+#ifdef TRAFFICLIGHT_REPORT_DRIFT
+    StepScheduler::setDriftReporting(true);
+#endif
+
+    // Written before core 1 starts, and afterwards only by the console's save command on core 1, which parks this core
+    // in RAM while the flash is busy.
+    loadConfig();
+    releaseUnusedBootPins();
+    setUpSystems();
+
     multicore_launch_core1(&inputsThread);
+    multicore_lockout_victim_init();
     lightsThread();
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "Hardware/hardware.h"
+
+#include "request_channel.h"
+
+bool RequestChannel::post(RequestEvent::Type type, uint32_t value)
+{
+    return post(type, value, Hardware::clock().now());
+}
+
+bool RequestChannel::post(RequestEvent::Type type, uint32_t value, std::chrono::microseconds timestamp)
+{
+    RequestEvent event;
+    event.type = type;
+    event.value = value;
+    event.timestamp = timestamp;
+
+    if (_queue.push(event)) {
+        Hardware::clock().notifyEvent();
+        return true;
+    }
+
+    _droppedCount.store(_droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    return false;
+}
+
+bool RequestChannel::receive(RequestEvent &event)
+{
+    return _queue.pop(event);
+}
+
+bool RequestChannel::hasPending() const
+{
+    return !_queue.empty();
+}
+
+uint32_t RequestChannel::getDroppedCount() const
+{
+    return _droppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "spsc_queue.h"
+
+/// @brief A request sent to a system from outside of the core running it, stamped with the time it was made.
+struct RequestEvent
+{
+    enum class Type : uint8_t { Crossing, NextGroup, ModeChange };
+
+    Type type = Type::Crossing;
+    uint32_t value = 0;
+    std::chrono::microseconds timestamp = std::chrono::microseconds(0);
+};
+
+/// @brief Carries typed, timestamped requests from one producer (normally the inputs core) to the core running a system
+/// without locks. Requests posted while the channel is full are dropped and counted.
+class RequestChannel
+{
+public:
+    static constexpr size_t Capacity = 16;
+
+    /// @brief The number of channels a system takes requests on, as each producer needs its own. Crossing buttons post
+    /// to channel 0.
+    static constexpr size_t ProducerCount = 2;
+
+    /// @brief Posts a request and wakes the core if it is waiting in AbstractClock::waitForEvent(). Must only be called
+    /// from a single producer.
+    bool post(RequestEvent::Type type, uint32_t value = 0);
+
+    /// @brief Posts a request that was made at the given time, such as when a button interrupt fired.
+    bool post(RequestEvent::Type type, uint32_t value, std::chrono::microseconds timestamp);
+
+    /// @brief Takes the oldest pending request. Must only be called from the core running the system.
+    bool receive(RequestEvent &event);
+
+    bool hasPending() const;
+
+    uint32_t getDroppedCount() const;
+
+private:
+    SpscQueue<RequestEvent, Capacity> _queue;
+
+    std::atomic<uint32_t> _droppedCount = 0;
+};
@@ -0,0 +1,59 @@
+#include <algorithm>
+
+#include "Hardware/hardware.h"
+#include "heartbeat.h"
+
+#include "safe_mode.h"
+
+SafeMode::SafeMode(std::shared_ptr<RunnableSystem> system) : _system(system)
+{
+}
+
+void SafeMode::enter()
+{
+    Hardware::watchdog().enable(Heartbeat::WatchdogTimeout);
+
+    _system->start();
+    _step = _system->advance();
+    _resetToSafeTime = Hardware::clock().now();
+
+    Hardware::watchdog().kick();
+}
+
+void SafeMode::run(size_t steps)
+{
+    auto &clock = Hardware::clock();
+
+    for (size_t step = 0; step < steps || steps == Forever; ++step) {
+        switch (_step.type) {
+            case SystemStep::Type::Delay:
+                wait(clock.now() + _step.delay);
+                break;
+            case SystemStep::Type::AwaitRequest:
+                wait(clock.now() + Heartbeat::Grace);
+                break;
+            case SystemStep::Type::Finished:
+                _system->start();
+                break;
+        }
+
+        _step = _system->advance();
+        Hardware::watchdog().kick();
+    }
+}
+
+std::chrono::microseconds SafeMode::getResetToSafeTime() const
+{
+    return _resetToSafeTime;
+}
+
+void SafeMode::wait(std::chrono::microseconds time)
+{
+    auto &clock = Hardware::clock();
+    auto kickInterval = std::chrono::duration_cast<std::chrono::microseconds>(Heartbeat::WatchdogTimeout) / 2;
+
+    while (clock.now() < time) {
+        clock.sleepUntil(std::min(time, clock.now() + kickInterval));
+        Hardware::watchdog().kick();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "Systems/runnable_system.h"
+
+/// @brief Runs a system that shows safe lights, such as a FlashingRedSystem, with nothing else running, for after the
+/// watchdog has reset the board. The watchdog is kicked straight from the loop, including part way through long steps,
+/// so a stall in safe mode resets back into it.
+class SafeMode
+{
+public:
+    static constexpr size_t Forever = (size_t)-1;
+
+    SafeMode(std::shared_ptr<RunnableSystem> system);
+
+    /// @brief Enables the watchdog and shows the system's first step, which should be safe, straight away.
+    void enter();
+
+    /// @brief Carries on running the system for the given number of steps.
+    void run(size_t steps = Forever);
+
+    /// @brief Gets the clock time the first step was shown at. The Pico's clock starts at reset, so this is how long
+    /// the lights took to become safe after the reset.
+    std::chrono::microseconds getResetToSafeTime() const;
+
+private:
+    std::shared_ptr<RunnableSystem> _system;
+
+    SystemStep _step;
+    std::chrono::microseconds _resetToSafeTime = std::chrono::microseconds(0);
+
+    void wait(std::chrono::microseconds time);
+};
\ No newline at end of file
@@ -6,11 +6,42 @@ Sequence::Sequence()
 
 void Sequence::add(TrafficLight::Light light, std::chrono::milliseconds delay)
 {
-    _sequences.push_back({light, delay});
+    ++_revision;
+
+    SequenceStep step;
+    step.light = light;
+    step.delay = delay;
+
+    _sequences.push_back(step);
+}
+
+void Sequence::repeat(size_t blockLength, unsigned int times)
+{
+    ++_revision;
+
+    SequenceStep step;
+    step.type = SequenceStep::Type::Repeat;
+    step.blockLength = blockLength;
+    step.repeatCount = times;
+
+    _sequences.push_back(step);
+}
+
+void Sequence::repeatFor(size_t blockLength, std::chrono::milliseconds duration)
+{
+    ++_revision;
+
+    SequenceStep step;
+    step.type = SequenceStep::Type::Repeat;
+    step.blockLength = blockLength;
+    step.delay = duration;
+
+    _sequences.push_back(step);
 }
 
 void Sequence::clear()
 {
+    ++_revision;
     _sequences.clear();
 }
 
@@ -33,13 +64,13 @@ bool Sequence::next()
 
 size_t Sequence::count() const
 {
-    return _sequences.size();
+    return getSteps().countLightSteps();
 }
 
 TrafficLight::Light Sequence::getLightForIndex(size_t index) const
 {
-    if (index < count()) {
-        return std::get<0>(_sequences[index]);
+    if (auto step = getSteps().findLightStep(index)) {
+        return step->light;
     }
 
     return TrafficLight::None;
@@ -52,8 +83,8 @@ TrafficLight::Light Sequence::getCurrentLight() const
 
 std::chrono::milliseconds Sequence::getDelayForIndex(size_t index) const
 {
-    if (index < count()) {
-        return std::get<1>(_sequences[index]);
+    if (auto step = getSteps().findLightStep(index)) {
+        return step->delay;
     }
 
     return std::chrono::milliseconds(0);
@@ -66,5 +97,15 @@ std::chrono::milliseconds Sequence::getCurrentDelay() const
 
 std::tuple<TrafficLight::Light, std::chrono::milliseconds> Sequence::getCurrent() const
 {
-    return _sequences[_index];
+    return {getCurrentLight(), getCurrentDelay()};
+}
+
+SequenceSteps Sequence::getSteps() const
+{
+    return {_sequences.data(), _sequences.size()};
 }
+
+uint32_t Sequence::getRevision() const
+{
+    return _revision;
+}
\ No newline at end of file
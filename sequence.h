@@ -4,8 +4,10 @@
 #include <list>
 #include <tuple>
 #include <chrono>
+#include <cstdint>
 
 #include "trafficlight.h"
+#include "sequence_step.h"
 
 class Sequence
 {
@@ -13,9 +15,17 @@ public:
     Sequence();
 
     void add(TrafficLight::Light light, std::chrono::milliseconds delay);
+
+    /// @brief Repeats the last blockLength steps so they run the given number of times in total.
+    void repeat(size_t blockLength, unsigned int times);
+
+    /// @brief Repeats the last blockLength steps until they have run for at least the given duration.
+    void repeatFor(size_t blockLength, std::chrono::milliseconds duration);
     void clear();
     void restart();
 
+    /// @brief The steps below walk only the steps that show lights, each once, in the order they were added. Repeats
+    /// are skipped rather than expanded, so use getSteps() to see exactly what a Controller will show.
     bool next();
 
     size_t count() const;
@@ -27,8 +37,14 @@ public:
     
     std::tuple<TrafficLight::Light, std::chrono::milliseconds> getCurrent() const;
 
+    SequenceSteps getSteps() const;
+
+    /// @brief Counts every change made to the steps, so anything built from them can tell when it is out of date.
+    uint32_t getRevision() const;
+
 private:
     size_t _index = 0;
+    uint32_t _revision = 0;
 
-    std::vector<std::tuple<TrafficLight::Light, std::chrono::milliseconds>> _sequences;
+    std::vector<SequenceStep> _sequences;
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "trafficlight.h"
+
+/// @brief A single step of a sequence. Most steps show lights for a delay, but a Repeat step sends the controller back
+/// over the blockLength steps before it, so flashing doesn't need a step per flash. A repeat stops once the block has run
+/// repeatCount times in total, or once the block's delays add up to at least delay when repeatCount is 0. Repeats can't be
+/// nested.
+struct SequenceStep
+{
+    enum class Type : uint8_t { Lights, Repeat };
+
+    Type type = Type::Lights;
+    TrafficLight::Light light = TrafficLight::Light::None;
+    std::chrono::milliseconds delay = std::chrono::milliseconds(0);
+    uint16_t blockLength = 0;
+    uint32_t repeatCount = 0;
+};
+
+/// @brief A non-owning view over a contiguous run of steps, so a Controller can walk a Sequence and a FixedSequence in
+/// the same way.
+struct SequenceSteps
+{
+    const SequenceStep *steps = nullptr;
+    size_t count = 0;
+
+    /// @brief Counts the steps that show lights, leaving out repeats.
+    constexpr size_t countLightSteps() const
+    {
+        size_t lightSteps = 0;
+
+        for (size_t index = 0; index < count; ++index) {
+            if (steps[index].type == SequenceStep::Type::Lights) {
+                ++lightSteps;
+            }
+        }
+
+        return lightSteps;
+    }
+
+    /// @brief Finds the step that shows lights at the given index, counting only steps that show lights.
+    /// @return The step, or null if there are fewer light steps.
+    constexpr const SequenceStep *findLightStep(size_t lightIndex) const
+    {
+        for (size_t index = 0; index < count; ++index) {
+            if (steps[index].type == SequenceStep::Type::Lights && lightIndex-- == 0) {
+                return &steps[index];
+            }
+        }
+
+        return nullptr;
+    }
+};
@@ -0,0 +1,1382 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Hardware/hardware.h"
+#include "Hardware/simulated_gpio.h"
+#include "Hardware/virtual_clock.h"
+#include "Hardware/simulated_serial.h"
+#include "Hardware/simulated_flash.h"
+#include "Hardware/simulated_watchdog.h"
+
+#include "Systems/sequenced_interruptable_system.h"
+#include "Systems/single_interruptable_crossing_system.h"
+#include "Systems/na_stop_give_way_system.h"
+#include "Systems/light_test_system.h"
+#include "Systems/all_red_system.h"
+#include "Systems/flashing_red_system.h"
+
+#include "trafficlight.h"
+#include "trafficlight_group.h"
+#include "controller.h"
+#include "common_sequences.h"
+#include "conflict_monitor.h"
+#include "heartbeat.h"
+#include "safe_mode.h"
+#include "step_scheduler.h"
+#include "cooperative_scheduler.h"
+#include "system_supervisor.h"
+#include "frame_pipeline.h"
+#include "trace_recorder.h"
+#include "console.h"
+#include "time_of_day.h"
+#include "crossing_button.h"
+#include "config_store.h"
+#include "stored_config.h"
+
+static std::atomic<bool> _countAllocations(false);
+static std::atomic<size_t> _allocationCount(0);
+
+static void countAllocation()
+{
+    if (_countAllocations) {
+        ++_allocationCount;
+    }
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *memory, size_t size);
+
+    //Replaces the C allocator for the whole program, so allocations made inside the C library, such as stdio buffers,
+    //are counted along with the standard operator new, which allocates through malloc.
+    void *malloc(size_t size)
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *memory, size_t size)
+    {
+        countAllocation();
+        return __libc_realloc(memory, size);
+    }
+}
+#else
+//Without glibc's allocator to hook, only allocations made through operator new are counted.
+void *operator new(size_t size)
+{
+    countAllocation();
+
+    if (auto memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+#endif
+
+/// @brief Simulated GPIO where every write also costs some virtual time, to show how the schedule absorbs the time spent
+/// outside of sleeping.
+class CostlyGpio : public SimulatedGpio
+{
+public:
+    CostlyGpio(std::shared_ptr<VirtualClock> clock, std::chrono::microseconds cost) : _clock(clock), _cost(cost) {}
+
+    void putMasked(uint32_t mask, uint32_t values) override
+    {
+        SimulatedGpio::putMasked(mask, values);
+        _clock->advance(_cost);
+    }
+
+private:
+    std::shared_ptr<VirtualClock> _clock;
+    std::chrono::microseconds _cost;
+};
+
+/// @brief Simulated GPIO that keeps every write along with the time it was made and the state of the pins after it.
+class RecordingGpio : public SimulatedGpio
+{
+public:
+    RecordingGpio(std::shared_ptr<AbstractClock> clock) : _clock(clock) {}
+
+    void putMasked(uint32_t mask, uint32_t values) override
+    {
+        SimulatedGpio::putMasked(mask, values);
+        _writes.push_back({ _clock->now(), getState() });
+    }
+
+    const std::vector<std::pair<std::chrono::microseconds, uint32_t>> &getWrites() const
+    {
+        return _writes;
+    }
+
+private:
+    std::shared_ptr<AbstractClock> _clock;
+    std::vector<std::pair<std::chrono::microseconds, uint32_t>> _writes;
+};
+
+/// @brief Simulated GPIO that calls back after every write, so something can be done at a point in a sequence.
+class HookedGpio : public SimulatedGpio
+{
+public:
+    void putMasked(uint32_t mask, uint32_t values) override
+    {
+        SimulatedGpio::putMasked(mask, values);
+
+        if (onWrite) {
+            onWrite();
+        }
+    }
+
+    std::function<void()> onWrite;
+};
+
+/// @brief Virtual clock that stands in for the inputs core while the lights core sleeps, calling Heartbeat::service() at
+/// the same interval the firmware's inputs loop does.
+class ServicedClock : public VirtualClock
+{
+public:
+    static constexpr std::chrono::milliseconds ServiceInterval = std::chrono::milliseconds(5);
+
+    void sleepUntil(std::chrono::microseconds time) override
+    {
+        while (now() < time) {
+            VirtualClock::sleepUntil(std::min<std::chrono::microseconds>(time, now() + ServiceInterval));
+            Heartbeat::service();
+        }
+    }
+
+    bool waitForEvent(std::chrono::microseconds deadline) override
+    {
+        if (deadline != std::chrono::microseconds::max()) {
+            sleepUntil(deadline);
+        }
+
+        return VirtualClock::waitForEvent(deadline);
+    }
+};
+
+std::vector<std::shared_ptr<TrafficLight>> createTrafficLights()
+{
+    auto northTrafficLight = std::make_shared<TrafficLight>(0u, 1u, 2u, 3u, 4u, TrafficLight::LedType::CommonAnode);
+    auto southTrafficLight = std::make_shared<TrafficLight>(5u, 6u, 7u, 8u, 9u, TrafficLight::LedType::CommonAnode);
+
+    return { northTrafficLight, southTrafficLight };
+}
+
+int runCycle(std::shared_ptr<SimulatedGpio> gpio, std::shared_ptr<VirtualClock> clock)
+{
+    auto system = std::make_shared<SequencedInterruptableSystem>(createTrafficLights(), SequencedInterruptableSystem::SequenceType::Auto);
+    system->getRequestChannel().post(RequestEvent::Type::Crossing);
+
+    gpio->resetWriteCount();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    system->run();
+    auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart);
+
+    printf("SequencedInterruptableSystem cycle: %lld ms simulated in %lld us, %llu pin writes, crossing served after %lld ms\n",
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(clock->now()).count(),
+        (long long)wallTime.count(),
+        (unsigned long long)gpio->getWriteCount(),
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(system->getCrossingLatency()).count());
+
+    return 0;
+}
+
+/// @brief Builds every system, runs each one once to finish any lazy set up, then runs them all again counting every
+/// heap allocation. Once a system is set up its run() must not touch the heap.
+int checkAllocations()
+{
+    auto trafficLights = createTrafficLights();
+
+    auto sequencedSystem = std::make_shared<SequencedInterruptableSystem>(trafficLights);
+    auto standardCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Standard);
+    auto flashingCrossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+    auto stopGiveWaySystem = std::make_shared<NAStopGiveWaySystem>(trafficLights, 1u);
+    auto lightTestSystem = std::make_shared<LightTestSystem>(trafficLights);
+
+    auto runAll = [&]() {
+        sequencedSystem->requestCrossing();
+        sequencedSystem->run();
+        standardCrossingSystem->requestCrossing();
+        standardCrossingSystem->run();
+        flashingCrossingSystem->requestCrossing();
+        flashingCrossingSystem->run();
+        stopGiveWaySystem->run();
+        lightTestSystem->run();
+    };
+
+    runAll();
+
+    _allocationCount = 0;
+    _countAllocations = true;
+    runAll();
+    _countAllocations = false;
+
+    printf("Heap allocations after set up: %zu\n", _allocationCount.load());
+
+    return _allocationCount == 0 ? 0 : 1;
+}
+
+/// @brief Runs the given number of SequencedInterruptableSystem cycles with every pin write costing virtual time and
+/// reports the drift of each one. The cumulative drift should stay at the cost of a single write however many cycles run.
+int reportDrift(std::shared_ptr<VirtualClock> clock, int cycles)
+{
+    Hardware::setGpio(std::make_shared<CostlyGpio>(clock, std::chrono::microseconds(250)));
+    StepScheduler::setDriftReporting(true);
+
+    auto system = std::make_shared<SequencedInterruptableSystem>(createTrafficLights());
+
+    for (auto cycle = 0; cycle < cycles; ++cycle) {
+        system->requestCrossing();
+        system->run();
+    }
+
+    auto expected = std::chrono::microseconds(250);
+
+    return StepScheduler::getCumulativeDrift() <= expected ? 0 : 1;
+}
+
+/// @brief Runs the given number of SequencedInterruptableSystem cycles with every pin write costing virtual time and
+/// prints the step lateness, cycle and phase histograms they leave behind.
+int printHistograms(std::shared_ptr<VirtualClock> clock, int cycles)
+{
+    Hardware::setGpio(std::make_shared<CostlyGpio>(clock, std::chrono::microseconds(250)));
+    StepScheduler::getLatenessHistogram().clear();
+
+    auto system = std::make_shared<SequencedInterruptableSystem>(createTrafficLights());
+
+    for (auto cycle = 0; cycle < cycles; ++cycle) {
+        system->requestCrossing();
+        system->run();
+    }
+
+    StepScheduler::getLatenessHistogram().print("step lateness");
+    system->getCycleDurations().print("cycle duration");
+    system->getPhaseDurations(SequencedInterruptableSystem::Phase::RedToGreen).print("red to green phase");
+    system->getPhaseDurations(SequencedInterruptableSystem::Phase::GreenToRed).print("green to red phase");
+    system->getPhaseDurations(SequencedInterruptableSystem::Phase::Crossing).print("crossing phase");
+
+    return 0;
+}
+
+/// @brief Drives two sequenced junctions and a standalone crossing on disjoint pins from one core for an hour of virtual
+/// time and reports how many cycles each completed.
+int runIntersections(std::shared_ptr<SimulatedGpio> gpio, std::shared_ptr<VirtualClock> clock)
+{
+    auto firstJunction = std::make_shared<SequencedInterruptableSystem>(std::vector<std::shared_ptr<TrafficLight>> {
+        std::make_shared<TrafficLight>(0u, 1u, 2u, 3u, 4u), std::make_shared<TrafficLight>(5u, 6u, 7u, 8u, 9u) });
+    auto secondJunction = std::make_shared<SequencedInterruptableSystem>(std::vector<std::shared_ptr<TrafficLight>> {
+        std::make_shared<TrafficLight>(10u, 11u, 12u), std::make_shared<TrafficLight>(13u, 14u, 15u) }, SequencedInterruptableSystem::SequenceType::Auto, SequencedInterruptableSystem::LightType::Red_Yellow_Green, SequencedInterruptableSystem::CrossingType::None);
+    auto crossing = std::make_shared<SingleInterruptableCrossingSystem>(std::vector<std::shared_ptr<TrafficLight>> {
+        std::make_shared<TrafficLight>(16u, 17u, 18u, 19u, 20u) });
+
+    CooperativeScheduler scheduler;
+    scheduler.addSystem(firstJunction);
+    scheduler.addSystem(secondJunction);
+    scheduler.addSystem(crossing);
+
+    crossing->getRequestChannel().post(RequestEvent::Type::Crossing);
+    gpio->resetWriteCount();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    scheduler.runUntil(clock->now() + std::chrono::hours(1));
+    auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart);
+
+    printf("1 hour of 3 systems on one core simulated in %lld us, %llu pin writes\n", (long long)wallTime.count(), (unsigned long long)gpio->getWriteCount());
+
+    for (size_t index = 0; index < scheduler.count(); ++index) {
+        printf("system %zu: %u cycles\n", index, scheduler.getCycleCount(index));
+    }
+
+    return 0;
+}
+
+/// @brief Runs SequencedInterruptableSystem cycles directly, then again with the system planning on one thread and a
+/// FramePipeline executor making the writes on another. Fails unless the executor makes the same writes at the same
+/// times, shifted by the lookahead.
+int runPipeline(std::shared_ptr<VirtualClock> clock, int cycles)
+{
+    auto runCycles = [cycles](std::shared_ptr<SequencedInterruptableSystem> system) {
+        StepScheduler::resynchronise();
+
+        for (auto cycle = 0; cycle < cycles; ++cycle) {
+            system->requestCrossing();
+            system->run();
+        }
+    };
+
+    auto directGpio = std::make_shared<RecordingGpio>(clock);
+    Hardware::setGpio(directGpio);
+    runCycles(std::make_shared<SequencedInterruptableSystem>(createTrafficLights()));
+
+    auto executorClock = std::make_shared<VirtualClock>();
+    auto pipelinedGpio = std::make_shared<RecordingGpio>(executorClock);
+    FramePipeline pipeline(pipelinedGpio, clock);
+    pipeline.setExecutorClock(executorClock);
+
+    Hardware::setGpio(pipeline.getPlannerGpio());
+    Hardware::setClock(pipeline.getPlannerClock());
+
+    auto system = std::make_shared<SequencedInterruptableSystem>(createTrafficLights());
+    std::atomic<bool> planning(true);
+
+    std::thread planner([&]() {
+        runCycles(system);
+        planning = false;
+    });
+
+    while (true) {
+        if (pipeline.executeNext()) {
+            continue;
+        }
+
+        if (!planning) {
+            while (pipeline.executeNext()) {}
+            break;
+        }
+
+        std::this_thread::yield();
+    }
+
+    planner.join();
+
+    Hardware::setClock(clock);
+
+    auto &direct = directGpio->getWrites();
+    auto &pipelined = pipelinedGpio->getWrites();
+    auto matches = direct.size() == pipelined.size();
+
+    for (size_t index = 0; matches && index < direct.size(); ++index) {
+        auto directTime = direct[index].first - direct.front().first;
+        auto pipelinedTime = pipelined[index].first - pipelined.front().first;
+
+        matches = directTime == pipelinedTime && direct[index].second == pipelined[index].second;
+    }
+
+    printf("%d cycles: %zu writes direct, %u through the pipeline, max lateness %lld us, %s\n", cycles, direct.size(),
+        pipeline.getExecutedCount(), (long long)pipeline.getMaximumLateness().count(), matches ? "timelines match" : "timelines differ");
+
+    return matches ? 0 : 1;
+}
+
+/// @brief Runs a SequencedInterruptableSystem cycle and a flashing crossing and dumps the trace they left, in the same
+/// format the firmware prints. Pipe it into trafficlight_trace_decoder to read it.
+int dumpTrace()
+{
+    auto trafficLights = createTrafficLights();
+    auto sequencedSystem = std::make_shared<SequencedInterruptableSystem>(trafficLights);
+    auto crossingSystem = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+
+    TraceRecorder::clear();
+
+    //A mode the system doesn't have, as could be typed into the console, shows up as rejected.
+    sequencedSystem->getRequestChannel().post(RequestEvent::Type::ModeChange, 7);
+    sequencedSystem->requestCrossing();
+    sequencedSystem->run();
+    crossingSystem->requestCrossing();
+    crossingSystem->run();
+
+    TraceRecorder::dump();
+
+    return 0;
+}
+
+enum class StressTimings
+{
+    First,
+    Second,
+    Third,
+    Fourth,
+    Count
+};
+
+/// @brief A system that does nothing but expose its timings, so both sides of a timing update can be driven directly.
+class TimingStressSystem : public AbstractSystem<StressTimings>
+{
+public:
+    TimingStressSystem()
+    {
+        setUpStandardTimings();
+    }
+
+    void start() override {}
+
+    SystemStep advance() override
+    {
+        return SystemStep::finished();
+    }
+
+    bool pickUpTimings()
+    {
+        return updateTimings();
+    }
+
+    /// @brief Checks every timing of every group matches, as each published profile holds a single value throughout.
+    bool readTimings(std::chrono::milliseconds &value) const
+    {
+        value = getTiming(StressTimings::First);
+
+        for (int group = -1; group < MaximumTimingGroups; ++group) {
+            for (size_t timing = 0; timing < TimingCount; ++timing) {
+                if (getTiming((StressTimings)timing, group) != value) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+protected:
+    std::chrono::milliseconds getStandardTiming(StressTimings timing) const override
+    {
+        return std::chrono::milliseconds(0);
+    }
+};
+
+/// @brief Publishes the given number of timing profiles from one thread while another picks them up and reads them as
+/// fast as it can. Fails if the reader ever sees a profile that is partly written or older than one it already saw.
+int stressTimings(int publishes)
+{
+    TimingStressSystem system;
+    std::atomic<bool> writing(true);
+
+    std::thread writer([&]() {
+        for (auto publish = 1; publish <= publishes; ++publish) {
+            auto profile = system.getStandardTimingProfile();
+
+            for (size_t timing = 0; timing < TimingStressSystem::TimingCount; ++timing) {
+                profile.set((StressTimings)timing, std::chrono::milliseconds(publish));
+            }
+
+            for (int group = 0; group < TimingStressSystem::MaximumTimingGroups; ++group) {
+                profile.set(StressTimings::Second, std::chrono::milliseconds(publish), group);
+            }
+
+            system.publishTimings(profile);
+        }
+
+        writing = false;
+    });
+
+    size_t updates = 0;
+    size_t failures = 0;
+    auto last = std::chrono::milliseconds(0);
+
+    auto check = [&]() {
+        std::chrono::milliseconds value;
+
+        if (!system.readTimings(value) || value < last) {
+            ++failures;
+        }
+
+        last = value;
+    };
+
+    while (writing) {
+        if (system.pickUpTimings()) {
+            ++updates;
+        }
+
+        check();
+    }
+
+    writer.join();
+
+    system.pickUpTimings();
+    check();
+
+    printf("%d profiles published, %zu picked up, %zu torn or out of order, last %lld ms\n", publishes, updates, failures, (long long)last.count());
+
+    return failures == 0 && last.count() == publishes ? 0 : 1;
+}
+
+/// @brief Steps the sequenced system while feeding the console a script of commands between steps, printing everything
+/// it replies. Then unplugs the host and checks the system keeps going while the console drops what it can't send.
+int runConsole(std::shared_ptr<VirtualClock> clock)
+{
+    auto serial = std::make_shared<SimulatedSerial>();
+    Hardware::setSerial(serial);
+
+    auto system = std::make_shared<SequencedInterruptableSystem>(createTrafficLights());
+
+    Console console;
+    console.addSystem("sequenced", system, &system->getRequestChannel(1));
+    console.addSystem("test", std::make_shared<LightTestSystem>(createTrafficLights()));
+    console.setActiveSystem(0);
+
+    auto allRed = std::make_shared<AllRedSystem>(createTrafficLights());
+    auto allRedIndex = console.addSystem("all-red", allRed);
+    TrafficLightGroup lights(createTrafficLights());
+    auto red = lights.getPinMask((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+    console.setParkingSystem(allRedIndex, lights.getBankMask(), (red ^ lights.getInvertMask()) & lights.getBankMask());
+    console.setRotationSystems(0x3); //Sequenced and test, as the firmware leaves all-red out of the rotation.
+
+    Hardware::setFlash(std::make_shared<SimulatedFlash>());
+
+    StoredConfig config;
+    config.addLight({ 0, 1, 2, 3, 4, 1 });
+    console.setConfig(config);
+
+    const char *script[] = { "help", "status", "timings", "set min-green 3000 0", "set crossing 5000", "cross", "next", "status",
+        "timings 0", "mode 0", "mode 7", "set nothing 1", "set green-delay 0", "bogus", "system test", "systems", "stats", "time", "time 25:00", "time 07:30", "time",
+        "config light 1 5 6 7 - - anode", "config light 2 31 6 7 - - cathode", "config timing sequenced min-green 4000 0",
+        "config timing sequenced green-delay 0", "config systems all-red", "config systems sequenced", "config", "save" };
+
+    //Not given to the system, so the timings set above stay, but it has to wait for the time of day just the same.
+    SequencedInterruptableSystem::Schedule schedule;
+    schedule.addPlan("off-peak", system->getStandardTimingProfile());
+    schedule.addPlan("peak", system->getStandardTimingProfile());
+    schedule.addSwitch(std::chrono::hours(7), "peak");
+    schedule.addSwitch(std::chrono::hours(10), "off-peak");
+
+    TimeOfDay::clear();
+    auto waitedForTime = schedule.getActivePlan() == SequencedInterruptableSystem::Schedule::NoPlan;
+
+    auto step = [&]() {
+        auto next = system->advance();
+        console.poll();
+
+        if (next.type == SystemStep::Type::Delay) {
+            clock->sleepFor(next.delay);
+        }
+
+        return next.type != SystemStep::Type::Finished;
+    };
+
+    system->start();
+
+    std::string replies;
+    for (auto *command : script) {
+        printf("> %s\n", command);
+        serial->feed(std::string(command) + "\n");
+
+        if (!step()) {
+            system->start();
+        }
+
+        auto reply = serial->takeOutput();
+        printf("%s", reply.c_str());
+        replies += reply;
+    }
+
+    //Flash is only written once the lights are parked on red, which the script's save was sent before.
+    allRed->start();
+    allRed->advance();
+    console.setActiveSystem(allRedIndex);
+    serial->feed("save\n");
+    console.poll();
+    auto saveReply = serial->takeOutput();
+    printf("> save\n%s", saveReply.c_str());
+    replies += saveReply;
+    console.setActiveSystem(0);
+
+    //Only the good changes are saved, and a config with a pin the board doesn't have is never loaded.
+    ConfigStore store;
+    store.load();
+
+    StoredConfig saved;
+    auto configSaved = saved.load(store) && saved.lightCount == 2 && saved.lights[1].greenPin == 7 && saved.overrideCount == 1
+        && saved.overrides[0].milliseconds == 4000 && saved.systems == 1 && replies.find("error: pins must be below 30") != std::string::npos
+        && replies.find("error: saving stops the lights, so only once system all-red has them on red") != std::string::npos
+        && replies.find("error: none of those systems take turns in the rotation") != std::string::npos
+        && saveReply.find("ok, saved with the lights stopped for") != std::string::npos;
+
+    saved.lights[1].greenPin = 40;
+    saved.save(store);
+    configSaved = configSaved && !StoredConfig().load(store);
+
+    //A mode the system doesn't have and a clearance time of 0 are both turned away before reaching the system.
+    std::chrono::milliseconds greenDelay;
+    auto guarded = replies.find("error: sequenced has modes 0 to 1") != std::string::npos && replies.find("error: green-delay takes 1000") != std::string::npos
+        && system->readTiming((size_t)SequencedInterruptableSystemTimings::DelayUntilGreenLight, -1, greenDelay) && greenDelay == std::chrono::seconds(2);
+
+    auto followsTime = waitedForTime && schedule.getActivePlan() == schedule.findPlan("peak");
+
+    //Set up like the firmware does, a scheduled system runs the off-peak timings with the stored changes on top until the
+    //time of day is set, then takes the plan for the time.
+    auto scheduled = std::make_shared<SequencedInterruptableSystem>(createTrafficLights());
+    auto offPeak = scheduled->getStandardTimingProfile();
+    offPeak.set(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(6));
+    auto peak = offPeak;
+    peak.set(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(9));
+    saved.applyTimings(0, offPeak);
+    saved.applyTimings(0, peak);
+
+    auto plans = std::make_shared<SequencedInterruptableSystem::Schedule>();
+    plans->addPlan("off-peak", offPeak);
+    plans->addPlan("peak", peak);
+    plans->addSwitch(std::chrono::hours(7), "peak");
+    plans->addSwitch(std::chrono::hours(10), "off-peak");
+    scheduled->setTimingSchedule(plans);
+    scheduled->publishTimings(offPeak);
+
+    auto hasTimings = [&](std::chrono::milliseconds crossingTime) {
+        std::chrono::milliseconds crossing, minimumGreen;
+        scheduled->start();
+        scheduled->advance();
+
+        return scheduled->readTiming((size_t)SequencedInterruptableSystemTimings::CrossingTime, -1, crossing) && crossing == crossingTime
+            && scheduled->readTiming((size_t)SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, 0, minimumGreen) && minimumGreen == std::chrono::seconds(4);
+    };
+
+    TimeOfDay::clear();
+    followsTime = followsTime && hasTimings(std::chrono::seconds(6));
+    TimeOfDay::set(std::chrono::hours(8));
+    followsTime = followsTime && hasTimings(std::chrono::seconds(9));
+
+    //With the ring full the trace is longer than the output buffer, so it takes a few polls to come out whole.
+    for (size_t record = 0; record < TraceRecorder::Capacity; ++record) {
+        TraceRecorder::record(0, TrafficLight::Light::Red, TraceRecord::Cause::ShowLights);
+    }
+
+    serial->feed("trace\n");
+    std::string trace;
+    for (auto poll = 0; poll < 100 && trace.find(TraceRecorder::EndLine) == std::string::npos; ++poll) {
+        console.poll();
+        trace += serial->takeOutput();
+    }
+
+    unsigned int traceCount = 0;
+    auto traceLines = (size_t)std::count(trace.begin(), trace.end(), '\n');
+    auto traced = sscanf(trace.c_str(), "trace begin %u", &traceCount) == 1 && traceCount == TraceRecorder::count() && traceLines == traceCount + 2;
+
+    std::chrono::milliseconds minimumGreen;
+    auto pickedUp = system->readTiming((size_t)SequencedInterruptableSystemTimings::MinimumTimeUntilRedLight, 0, minimumGreen) && minimumGreen == std::chrono::seconds(3);
+
+    serial->setWriteLimit(0);
+    for (auto command = 0; command < 20; ++command) {
+        serial->feed("timings\n");
+        console.poll();
+    }
+
+    auto steps = 0;
+    while (step()) {
+        ++steps;
+    }
+
+    serial->setWriteLimit(SimulatedSerial::Unlimited);
+    console.poll();
+    serial->takeOutput();
+
+    printf("min-green for group 0 picked up: %s, bad modes and timings refused: %s, config saved: %s, stored timings run until the time of day picks a plan: %s, trace of %u records read: %s, %d steps run with the host unplugged, %lu replies dropped\n",
+        pickedUp ? "yes" : "no", guarded ? "yes" : "no", configSaved ? "yes" : "no", followsTime ? "yes" : "no", traceCount, traced ? "yes" : "no", steps, (unsigned long)console.getDroppedCount());
+
+    return pickedUp && guarded && configSaved && followsTime && traced && steps > 0 && console.getDroppedCount() > 0 && console.getRequestedSystem() == 1 ? 0 : 1;
+}
+
+/// @brief Switches to all-red part way through a cycle of each system, at a safe point and straight away, from the
+/// moment green or a crossing shows or from the first step of systems without either. Every switch has to leave every
+/// vehicle and crossing light on red without cutting a steady yellow short, an immediate switch can't take longer than
+/// one at a safe point, and the all-red system has to take over from there in a single write.
+int runSwitching(std::shared_ptr<VirtualClock> clock)
+{
+    auto gpio = std::make_shared<HookedGpio>();
+    Hardware::setGpio(gpio);
+
+    auto trafficLights = createTrafficLights();
+    TrafficLightGroup lights(trafficLights);
+
+    auto isLit = [&](TrafficLight::Light light) {
+        return ((gpio->getState() ^ lights.getInvertMask()) & lights.getPinMask(light)) != 0;
+    };
+
+    auto isAllRed = [&]() {
+        auto red = lights.getPinMask((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing));
+        return ((gpio->getState() ^ lights.getInvertMask()) & lights.getPinMask(TrafficLight::Light::All)) == red;
+    };
+
+    auto sequenced = std::make_shared<SequencedInterruptableSystem>(trafficLights);
+    auto crossing = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Standard);
+    auto flashingCrossing = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights, SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+
+    SystemSupervisor supervisor;
+    supervisor.addSystem(sequenced);
+    supervisor.addSystem(crossing);
+    supervisor.addSystem(flashingCrossing);
+    supervisor.addSystem(std::make_shared<NAStopGiveWaySystem>(trafficLights, 1u));
+    supervisor.addSystem(std::make_shared<LightTestSystem>(trafficLights));
+    auto allRed = supervisor.addSystem(std::make_shared<AllRedSystem>(trafficLights));
+
+    const char *names[] = { "sequenced", "crossing", "flashing-crossing", "stop-give-way", "light-test" };
+    auto failures = 0;
+
+    for (auto run = 0; run < allRed + 3; ++run) {
+        // The signalled systems are run twice, switching away once from green and once from a crossing.
+        auto index = run < allRed ? run : run - allRed;
+        auto trigger = run < allRed ? TrafficLight::Light::Green : TrafficLight::Light::GreenCrossing;
+        auto safePointLatency = std::chrono::microseconds(0);
+
+        for (auto urgency : { SystemSupervisor::Urgency::AtSafePoint, SystemSupervisor::Urgency::Immediate }) {
+            if (trigger == TrafficLight::Light::GreenCrossing) {
+                sequenced->requestCrossing();
+                crossing->requestCrossing();
+                flashingCrossing->requestCrossing();
+            }
+
+            //A flashing crossing shows yellow along with it, so only a steady yellow is a clearance, which every sequence holds
+            //for 3s. Yellows that ended before the switch was asked for, such as the stop/give-way flashes, aren't timed.
+            auto yellowSince = std::chrono::microseconds(-1);
+            auto shortestYellow = std::chrono::microseconds::max();
+            auto requested = false;
+            gpio->onWrite = [&]() {
+                auto steadyYellow = isLit(TrafficLight::Light::Yellow) && !isLit(TrafficLight::Light::GreenCrossing);
+                if (steadyYellow && yellowSince.count() < 0) {
+                    yellowSince = clock->now();
+                }
+                else if (!steadyYellow && yellowSince.count() >= 0) {
+                    if (requested) {
+                        shortestYellow = std::min(shortestYellow, clock->now() - yellowSince);
+                    }
+                    yellowSince = std::chrono::microseconds(-1);
+                }
+
+                // The light test and flashing systems never show green, so are switched away from at their first step.
+                if (!requested && (isLit(trigger) || index >= 3)) {
+                    supervisor.requestSwitch(allRed, urgency);
+                    requested = true;
+                }
+            };
+
+            auto startedAt = clock->now();
+            auto switchTo = supervisor.runCycle(index);
+            auto switchedAt = clock->now();
+            auto stopped = isAllRed();
+            auto clearedYellow = shortestYellow >= std::chrono::seconds(3);
+
+            gpio->onWrite = nullptr;
+            gpio->resetWriteCount();
+            supervisor.runCycle(switchTo == SystemSupervisor::NoSystem ? allRed : switchTo);
+
+            auto immediate = urgency == SystemSupervisor::Urgency::Immediate;
+            auto latency = supervisor.getLastSwitchLatency();
+            auto passed = switchTo == allRed && gpio->getWriteCount() == 1 && stopped && clearedYellow && (!immediate || latency <= safePointLatency);
+            failures += passed ? 0 : 1;
+
+            if (!immediate) {
+                safePointLatency = latency;
+            }
+
+            printf("%s from %s %s: switched %s after %lld ms, %lld ms into the cycle, all red %s, yellow cleared %s: %s\n", names[index],
+                index >= 3 ? "its first step" : trigger == TrafficLight::Light::Green ? "green" : "crossing", immediate ? "now" : "at safe point", switchTo == allRed ? "to all-red" : "nowhere",
+                (long long)std::chrono::duration_cast<std::chrono::milliseconds>(latency).count(),
+                (long long)std::chrono::duration_cast<std::chrono::milliseconds>(switchedAt - startedAt).count(),
+                stopped ? "yes" : "no", clearedYellow ? "yes" : "no", passed ? "ok" : "FAILED");
+        }
+    }
+
+    auto &latencies = supervisor.getSwitchLatencies();
+    printf("%lu switches, max latency %lld ms, %d failed\n", (unsigned long)latencies.count(),
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(latencies.getMaximum()).count(), failures);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/// @brief Presses a crossing button the way a real one behaves, bouncing on both press and release, and checks only the
+/// presses are taken however long the button is held.
+int checkButton(std::shared_ptr<SimulatedGpio> gpio, std::shared_ptr<VirtualClock> clock)
+{
+    static constexpr uint ButtonPin = 13;
+
+    RequestChannel requests;
+    CrossingButton button(ButtonPin, requests);
+
+    auto bounce = [&](bool level) {
+        for (auto edge = 0; edge < 4; ++edge) {
+            gpio->setInput(ButtonPin, edge % 2 == 0 ? level : !level);
+            clock->advance(std::chrono::microseconds(300));
+        }
+
+        gpio->setInput(ButtonPin, level);
+    };
+
+    auto press = [&](std::chrono::milliseconds held, std::chrono::milliseconds releasedFor) {
+        bounce(true);
+        clock->advance(held);
+        bounce(false);
+        clock->advance(releasedFor);
+    };
+
+    clock->advance(std::chrono::seconds(1));
+
+    press(std::chrono::milliseconds(20), std::chrono::milliseconds(500));
+    press(std::chrono::milliseconds(400), std::chrono::milliseconds(500));
+    press(std::chrono::seconds(2), std::chrono::milliseconds(500));
+
+    auto pressCount = button.getPressCount();
+    size_t requestCount = 0;
+    RequestEvent event;
+    while (requests.receive(event)) {
+        ++requestCount;
+    }
+
+    printf("3 bouncing presses held for 20 ms, 400 ms and 2 s: %u presses, %u bounces, %zu requests\n", pressCount, button.getBounceCount(), requestCount);
+
+    return pressCount == 3 && requestCount == 3 ? 0 : 1;
+}
+
+/// @brief Shows steps that break the rules of a two group junction through a controller, and checks the conflict monitor
+/// puts every light on red in the same step, latches the right fault and holds the lights on red until it is cleared.
+int checkConflicts()
+{
+    auto gpio = std::make_shared<SimulatedGpio>();
+    Hardware::setGpio(gpio);
+
+    auto trafficLights = createTrafficLights();
+    auto north = std::make_shared<TrafficLightGroup>(std::vector<std::shared_ptr<TrafficLight>> { trafficLights[0] });
+    auto south = std::make_shared<TrafficLightGroup>(std::vector<std::shared_ptr<TrafficLight>> { trafficLights[1] });
+    auto matrix = std::make_shared<ConflictMatrix>(std::vector<std::shared_ptr<TrafficLightGroup>> { north, south });
+    TrafficLightGroup lights(trafficLights);
+
+    struct Scenario
+    {
+        const char *name;
+        TrafficLight::Light north;
+        TrafficLight::Light south;
+        ConflictFault fault;
+    };
+
+    const Scenario scenarios[] = {
+        { "north green then south green", TrafficLight::Light::Green, TrafficLight::Light::Green, ConflictFault::ConflictingGreens },
+        { "north green with green crossing", (TrafficLight::Light)(TrafficLight::Light::Green | TrafficLight::Light::GreenCrossing), TrafficLight::Light::Red, ConflictFault::GreenWithCrossing },
+        { "north green then south red", TrafficLight::Light::Green, TrafficLight::Light::Red, ConflictFault::None }
+    };
+
+    auto safeState = (lights.getPinMask((TrafficLight::Light)(TrafficLight::Light::Red | TrafficLight::Light::RedCrossing)) ^ lights.getInvertMask()) & lights.getBankMask();
+    auto failures = 0;
+
+    for (auto &scenario : scenarios) {
+        lights.showLights(TrafficLight::Light::Red);
+
+        Controller controller;
+        controller.setConflictMatrix(matrix);
+        controller.addTrafficLightGroup(north, 0);
+        controller.addTrafficLightGroup(south, 1);
+        controller.addSequence(std::make_shared<StaticSequence>(std::chrono::seconds(1), scenario.north), 0);
+        controller.addSequence(std::make_shared<StaticSequence>(std::chrono::seconds(1), scenario.south), 1);
+        controller.start();
+
+        //The step that breaks a rule has to leave every light on red, and nothing after it may change them.
+        std::chrono::milliseconds delay;
+        auto steps = 0;
+        auto stoppedAt = 0;
+        while (controller.advance(delay)) {
+            ++steps;
+            if (stoppedAt == 0 && ConflictMonitor::getFault() != ConflictFault::None) {
+                stoppedAt = gpio->getState() == safeState ? steps : -1;
+            }
+        }
+
+        lights.showLights(TrafficLight::Light::Green);
+        auto held = scenario.fault == ConflictFault::None || gpio->getState() == safeState;
+
+        auto fault = ConflictMonitor::getFault();
+        auto passed = fault == scenario.fault && held && (scenario.fault == ConflictFault::None || stoppedAt > 0);
+        failures += passed ? 0 : 1;
+
+        printf("%s: fault %d, all red at step %d, held: %s: %s\n", scenario.name, (int)fault, stoppedAt, held ? "yes" : "no", passed ? "ok" : "FAILED");
+
+        ConflictMonitor::clearFault();
+    }
+
+    //A matrix that can't hold every rule its groups need stops the lights at its first step rather than check only some.
+    std::vector<std::shared_ptr<TrafficLightGroup>> turns;
+    for (size_t turn = 0; turn <= ConflictMatrix::MaximumRules; ++turn) {
+        turns.push_back(turn % 2 == 0 ? north : south);
+    }
+
+    auto crowded = std::make_shared<ConflictMatrix>(turns);
+    lights.showLights(TrafficLight::Light::Green);
+
+    Controller controller;
+    controller.setConflictMatrix(crowded);
+    controller.addTrafficLightGroup(north, 0);
+    controller.addSequence(std::make_shared<StaticSequence>(std::chrono::seconds(1), TrafficLight::Light::Red), 0);
+    controller.start();
+
+    std::chrono::milliseconds delay;
+    while (controller.advance(delay)) {
+    }
+
+    auto fault = ConflictMonitor::getFault();
+    auto passed = !crowded->isComplete() && fault == ConflictFault::TooManyRules && gpio->getState() == safeState;
+    failures += passed ? 0 : 1;
+
+    printf("%zu turns needing more than %zu rules: fault %d, all red: %s: %s\n", turns.size(), ConflictMatrix::MaximumRules, (int)fault,
+        gpio->getState() == safeState ? "yes" : "no", passed ? "ok" : "FAILED");
+
+    ConflictMonitor::clearFault();
+
+    printf("%d failed\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/// @brief Runs every system with the inputs core kicking the watchdog through Heartbeat and checks it never runs out,
+/// then hangs the lights core part way through a step and checks the watchdog runs out in time. Finally reboots into
+/// safe mode as the firmware does after a watchdog reset and reports how long the lights took to become safe.
+int checkWatchdog()
+{
+    auto clock = std::make_shared<ServicedClock>();
+    auto gpio = std::make_shared<HookedGpio>();
+    auto watchdog = std::make_shared<SimulatedWatchdog>();
+    Hardware::setClock(clock);
+    Hardware::setGpio(gpio);
+    Hardware::setWatchdog(watchdog);
+
+    auto trafficLights = createTrafficLights();
+    auto sequenced = std::make_shared<SequencedInterruptableSystem>(trafficLights);
+    auto crossing = std::make_shared<SingleInterruptableCrossingSystem>(trafficLights);
+
+    SystemSupervisor supervisor;
+    supervisor.addSystem(std::make_shared<LightTestSystem>(trafficLights));
+    supervisor.addSystem(sequenced);
+    supervisor.addSystem(crossing);
+    supervisor.addSystem(std::make_shared<NAStopGiveWaySystem>(trafficLights, 1u));
+    supervisor.addSystem(std::make_shared<FlashingRedSystem>(trafficLights));
+
+    Heartbeat::start();
+
+    for (auto index = 0; index < 5; ++index) {
+        sequenced->requestCrossing();
+        crossing->requestCrossing();
+        supervisor.runCycle(index);
+    }
+
+    auto kicks = watchdog->getKickCount();
+    auto survived = !watchdog->hasExpired() && kicks > 0;
+    printf("every system run for %lld ms, %lu kicks, watchdog ran out: %s\n",
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(clock->now()).count(), (unsigned long)kicks, survived ? "no" : "yes");
+
+    //Hangs on the third pin write while the inputs core carries on polling.
+    auto writes = 0;
+    auto stalledFor = std::chrono::microseconds(-1);
+    gpio->onWrite = [&]() {
+        if (++writes != 3) {
+            return;
+        }
+
+        auto stalledAt = clock->now();
+        while (clock->now() - stalledAt < std::chrono::seconds(5) && stalledFor.count() < 0) {
+            clock->advance(ServicedClock::ServiceInterval);
+            Heartbeat::service();
+
+            if (watchdog->hasExpired()) {
+                stalledFor = clock->now() - stalledAt;
+            }
+        }
+    };
+
+    sequenced->requestCrossing();
+    supervisor.runCycle(1);
+    gpio->onWrite = nullptr;
+
+    auto limit = std::chrono::duration_cast<std::chrono::microseconds>(Heartbeat::Grace + Heartbeat::WatchdogTimeout) + ServicedClock::ServiceInterval;
+    auto caught = stalledFor.count() >= 0 && stalledFor <= limit;
+    printf("lights core hung: watchdog ran out after %lld ms (limit %lld ms)\n",
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(stalledFor).count(),
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(limit).count());
+
+    //Reboots into safe mode. Nothing is set up beforehand, as on the board.
+    clock->reset();
+    watchdog = std::make_shared<SimulatedWatchdog>();
+    watchdog->setCausedReboot(true);
+    Hardware::setWatchdog(watchdog);
+    gpio = std::make_shared<HookedGpio>();
+    Hardware::setGpio(gpio);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    SafeMode safeMode(std::make_shared<FlashingRedSystem>(createTrafficLights()));
+    safeMode.enter();
+    auto wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart);
+
+    TrafficLightGroup lights(trafficLights);
+    auto isLit = [&](TrafficLight::Light light) {
+        return ((gpio->getState() ^ lights.getInvertMask()) & lights.getPinMask(light)) != 0;
+    };
+
+    auto safe = isLit(TrafficLight::Light::Red) && isLit(TrafficLight::Light::RedCrossing) && !isLit(TrafficLight::Light::Green) && !isLit(TrafficLight::Light::Yellow) && !isLit(TrafficLight::Light::GreenCrossing);
+
+    safeMode.run(20);
+    auto held = !watchdog->hasExpired();
+
+    printf("safe mode: red %lld us after reset (%lld us of host time), flashed for %lld ms, watchdog ran out: %s\n",
+        (long long)safeMode.getResetToSafeTime().count(), (long long)wallTime.count(),
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(clock->now()).count(), held ? "no" : "yes");
+
+    return survived && caught && safe && held ? 0 : 1;
+}
+
+/// @brief Saves a config to file-backed flash over and over with the power cut part way through every other save, at
+/// points that land in both programming and erasing, and reboots from the file after each one. Fails if a reboot ever
+/// reads back anything but the last config saved in full or the one that was being saved, then shows how evenly the
+/// sectors wore.
+int runPowerCuts(const char *path, int saves)
+{
+    remove(path);
+
+    std::shared_ptr<SimulatedFlash> flash;
+    std::vector<uint32_t> eraseCounts(4, 0);
+    ConfigStore store;
+
+    auto reboot = [&]() {
+        if (flash) {
+            for (size_t sector = 0; sector < eraseCounts.size(); ++sector) {
+                eraseCounts[sector] += flash->getEraseCount(sector);
+            }
+        }
+
+        flash = std::make_shared<SimulatedFlash>(eraseCounts.size(), path);
+        Hardware::setFlash(flash);
+        store.load();
+    };
+
+    reboot();
+
+    StoredConfig config;
+    config.addOverride(1, 0, -1, std::chrono::milliseconds(0));
+
+    if (!config.save(store)) {
+        printf("first save failed\n");
+        return 1;
+    }
+
+    uint32_t saved = 0;
+    auto failures = 0;
+    auto interrupted = 0;
+
+    for (auto save = 1; save <= saves; ++save) {
+        config.overrides[0].milliseconds = (uint32_t)save;
+
+        //Steps the cut through the erase and program of a save, in steps that don't line up with either. Cuts past the
+        //end of a save that doesn't need an erase let it finish.
+        if (save % 2 == 0) {
+            flash->cutPowerAfter((size_t)save * 53 % (SimulatedFlash::SectorSize + ConfigStore::SlotSize));
+        }
+
+        auto written = config.save(store);
+
+        if (!flash->isPowered()) {
+            ++interrupted;
+        }
+
+        reboot();
+
+        StoredConfig loaded;
+        auto value = loaded.load(store) ? loaded.overrides[0].milliseconds : (uint32_t)-1;
+
+        if (value != (uint32_t)save && (written || value != saved)) {
+            printf("save %d: read back %ld after the power cut, expected %s%u\n", save, (long)(int32_t)value, written ? "" : "either that save or ", written ? save : saved);
+            ++failures;
+        }
+
+        saved = value;
+    }
+
+    reboot();
+
+    printf("%d saves, %d cut short by a power cut, %d read back wrong, sequence %u\n", saves, interrupted, failures, store.getSequence());
+    for (size_t sector = 0; sector < eraseCounts.size(); ++sector) {
+        printf("sector %zu erased %u times\n", sector, eraseCounts[sector]);
+    }
+
+    remove(path);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/// @brief A light timeline as the time of each change from the start of a run, in ms, and the state of the pins after it.
+using Timeline = std::vector<std::pair<long long, uint32_t>>;
+
+/// @brief Adds a state to a timeline if it is a change. Only the last state at each millisecond is kept, as states
+/// shown for less than that depend on how the steps happen to be split rather than on what can be seen.
+void addChange(Timeline &timeline, long long time, uint32_t state)
+{
+    if (!timeline.empty() && timeline.back().first == time) {
+        timeline.pop_back();
+    }
+
+    if (timeline.empty() || timeline.back().second != state) {
+        timeline.push_back({ time, state });
+    }
+}
+
+/// @brief Runs a system the same way as RunnableSystem::run(), but calls onAwait whenever it waits for a request so
+/// the request can be made.
+void runWithRequests(RunnableSystem &system, std::function<void()> onAwait)
+{
+    auto waitedForRequest = false;
+
+    system.start();
+
+    while (true) {
+        auto step = system.advance();
+
+        if (step.type == SystemStep::Type::Finished) {
+            break;
+        }
+
+        if (step.type == SystemStep::Type::AwaitRequest) {
+            onAwait();
+            waitedForRequest = true;
+            continue;
+        }
+
+        if (waitedForRequest) {
+            StepScheduler::resynchronise();
+            waitedForRequest = false;
+        }
+
+        StepScheduler::waitFor(step.delay);
+    }
+}
+
+/// @brief The behaviour each golden timeline holds, matching the sequences shown in the README.
+std::vector<std::pair<const char *, std::function<void(std::shared_ptr<VirtualClock>)>>> getConformanceScenarios()
+{
+    return {
+        { "sequenced", [](std::shared_ptr<VirtualClock>) {
+            SequencedInterruptableSystem system(createTrafficLights());
+            system.requestCrossing();
+            system.run();
+            system.run();
+        } },
+        { "sequenced-red-green", [](std::shared_ptr<VirtualClock>) {
+            SequencedInterruptableSystem system(createTrafficLights(), SequencedInterruptableSystem::SequenceType::Auto, SequencedInterruptableSystem::LightType::Red_Green);
+            system.setTiming(SequencedInterruptableSystemTimings::CrossingTime, std::chrono::seconds(3), 1);
+            system.requestCrossing();
+            system.run();
+        } },
+        { "sequenced-manual", [](std::shared_ptr<VirtualClock> clock) {
+            SequencedInterruptableSystem system(createTrafficLights(), SequencedInterruptableSystem::SequenceType::Manual);
+            runWithRequests(system, [&]() {
+                clock->advance(std::chrono::seconds(3));
+                system.getRequestChannel().post(RequestEvent::Type::NextGroup);
+            });
+        } },
+        { "crossing", [](std::shared_ptr<VirtualClock>) {
+            SingleInterruptableCrossingSystem system(createTrafficLights());
+            system.requestCrossing();
+            system.run();
+        } },
+        { "flashing-crossing", [](std::shared_ptr<VirtualClock>) {
+            SingleInterruptableCrossingSystem system(createTrafficLights(), SingleInterruptableCrossingSystem::CrossingStyle::Flashing);
+            system.requestCrossing();
+            system.run();
+        } },
+        { "stop-give-way", [](std::shared_ptr<VirtualClock>) {
+            NAStopGiveWaySystem system(createTrafficLights(), 1u);
+            system.run();
+        } },
+        { "light-test", [](std::shared_ptr<VirtualClock>) {
+            LightTestSystem system(createTrafficLights());
+            system.run();
+        } },
+    };
+}
+
+Timeline recordTimeline(std::shared_ptr<VirtualClock> clock, std::function<void(std::shared_ptr<VirtualClock>)> scenario)
+{
+    auto gpio = std::make_shared<RecordingGpio>(clock);
+    Hardware::setGpio(gpio);
+
+    auto startedAt = clock->now();
+    scenario(clock);
+
+    //Only changes are kept, so writes that leave the lights as they were don't count as a difference.
+    Timeline timeline;
+    for (auto &write : gpio->getWrites()) {
+        addChange(timeline, std::chrono::duration_cast<std::chrono::milliseconds>(write.first - startedAt).count(), write.second);
+    }
+
+    return timeline;
+}
+
+bool readTimeline(const std::string &path, Timeline &timeline)
+{
+    auto file = fopen(path.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        long long time = 0;
+        unsigned long state = 0;
+
+        if (line[0] != '#' && sscanf(line, "%lld %lx", &time, &state) == 2) {
+            addChange(timeline, time, (uint32_t)state);
+        }
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+bool writeTimeline(const std::string &path, const char *name, const Timeline &timeline)
+{
+    auto file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "# %s: the time of each light change in ms, then the state of pins 0-31 after it\n", name);
+    for (auto &change : timeline) {
+        fprintf(file, "%lld %08lx\n", change.first, (unsigned long)change.second);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+/// @brief Runs every system through set scenarios and checks the lights change the same way and at the same times as
+/// the golden timelines in directory, to within tolerance. With update set the golden timelines are written instead.
+int checkConformance(std::shared_ptr<VirtualClock> clock, const std::string &directory, long long tolerance, bool update)
+{
+    auto failures = 0;
+
+    for (auto &scenario : getConformanceScenarios()) {
+        auto path = directory + "/" + scenario.first + ".timeline";
+        auto timeline = recordTimeline(clock, scenario.second);
+
+        if (update) {
+            auto written = writeTimeline(path, scenario.first, timeline);
+            printf("%s: %zu changes %s %s\n", scenario.first, timeline.size(), written ? "written to" : "couldn't be written to", path.c_str());
+            failures += written ? 0 : 1;
+            continue;
+        }
+
+        Timeline golden;
+        if (!readTimeline(path, golden)) {
+            printf("%s: no golden timeline at %s\n", scenario.first, path.c_str());
+            ++failures;
+            continue;
+        }
+
+        auto matched = golden.size() == timeline.size();
+        size_t change = 0;
+
+        for (; matched && change < golden.size(); ++change) {
+            matched = golden[change].second == timeline[change].second && llabs(golden[change].first - timeline[change].first) <= tolerance;
+        }
+
+        if (matched) {
+            printf("%s: %zu changes match\n", scenario.first, timeline.size());
+            continue;
+        }
+
+        ++failures;
+
+        if (golden.size() != timeline.size()) {
+            printf("%s: %zu changes, golden timeline has %zu\n", scenario.first, timeline.size(), golden.size());
+        }
+        else {
+            --change;
+            printf("%s: change %zu is %08lx at %lld ms, golden timeline has %08lx at %lld ms\n", scenario.first, change,
+                (unsigned long)timeline[change].second, timeline[change].first, (unsigned long)golden[change].second, golden[change].first);
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    auto gpio = std::make_shared<SimulatedGpio>();
+    auto clock = std::make_shared<VirtualClock>();
+
+    Hardware::setGpio(gpio);
+    Hardware::setClock(clock);
+
+    if (argc > 1 && strcmp(argv[1], "--check-allocations") == 0) {
+        return checkAllocations();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--report-drift") == 0) {
+        return reportDrift(clock, argc > 2 ? atoi(argv[2]) : 10);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--histograms") == 0) {
+        return printHistograms(clock, argc > 2 ? atoi(argv[2]) : 10);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--intersections") == 0) {
+        return runIntersections(gpio, clock);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--pipeline") == 0) {
+        return runPipeline(clock, argc > 2 ? atoi(argv[2]) : 10);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--trace") == 0) {
+        return dumpTrace();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--stress-timings") == 0) {
+        return stressTimings(argc > 2 ? atoi(argv[2]) : 1000000);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--power-cuts") == 0) {
+        return runPowerCuts(argc > 2 ? argv[2] : "trafficlight_flash.bin", argc > 3 ? atoi(argv[3]) : 1000);
+    }
+
+    if (argc > 1 && (strcmp(argv[1], "--conformance") == 0 || strcmp(argv[1], "--update-golden") == 0)) {
+        return checkConformance(clock, argc > 2 ? argv[2] : TRAFFICLIGHT_GOLDEN_DIR, argc > 3 ? atoll(argv[3]) : 1, strcmp(argv[1], "--update-golden") == 0);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--console") == 0) {
+        return runConsole(clock);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--switching") == 0) {
+        return runSwitching(clock);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--conflicts") == 0) {
+        return checkConflicts();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--button") == 0) {
+        return checkButton(gpio, clock);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--watchdog") == 0) {
+        return checkWatchdog();
+    }
+
+    return runCycle(gpio, clock);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief A lock-free, fixed size, single producer single consumer ring. Only needs atomic loads and stores, so it is
+/// safe between the two RP2040 cores (which have no atomic read-modify-write instructions) as well as between threads
+/// on the host. Exactly one thread may push and exactly one thread may pop.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    bool push(const T &item)
+    {
+        auto head = _head.load(std::memory_order_relaxed);
+        auto tail = _tail.load(std::memory_order_acquire);
+
+        if (head - tail >= Capacity) {
+            return false;
+        }
+
+        _items[head & (Capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto head = _head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            return false;
+        }
+
+        item = _items[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /// @brief Copies the oldest item without taking it. Consumer side only.
+    bool peek(T &item) const
+    {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto head = _head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            return false;
+        }
+
+        item = _items[tail & (Capacity - 1)];
+
+        return true;
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    constexpr size_t capacity() const
+    {
+        return Capacity;
+    }
+
+private:
+    T _items[Capacity] = {};
+
+    std::atomic<uint32_t> _head = 0;
+    std::atomic<uint32_t> _tail = 0;
+};
@@ -0,0 +1,125 @@
+#include <cstdio>
+
+#include "Hardware/hardware.h"
+#include "heartbeat.h"
+
+#include "step_scheduler.h"
+
+bool StepScheduler::_started = false;
+bool StepScheduler::_reportDrift = false;
+
+uint32_t StepScheduler::_cycle = 0;
+
+std::chrono::microseconds StepScheduler::_deadline = std::chrono::microseconds(0);
+std::chrono::microseconds StepScheduler::_lateness = std::chrono::microseconds(0);
+std::chrono::microseconds StepScheduler::_maximumCycleLateness = std::chrono::microseconds(0);
+std::chrono::microseconds StepScheduler::_carriedDrift = std::chrono::microseconds(0);
+std::chrono::microseconds StepScheduler::_cycleScheduled = std::chrono::microseconds(0);
+
+DurationHistogram StepScheduler::_latenessHistogram;
+
+void StepScheduler::waitFor(std::chrono::milliseconds delay)
+{
+    moveDeadline(delay);
+
+    Hardware::clock().sleepUntil(_deadline);
+
+    recordLateness();
+}
+
+bool StepScheduler::waitFor(std::chrono::milliseconds delay, const std::atomic<uint32_t> &watched, uint32_t value)
+{
+    auto &clock = Hardware::clock();
+
+    moveDeadline(delay);
+
+    while (!clock.waitForEvent(_deadline)) {
+        if (watched.load(std::memory_order_acquire) != value) {
+            return false;
+        }
+    }
+
+    recordLateness();
+
+    return true;
+}
+
+void StepScheduler::resynchronise()
+{
+    _carriedDrift += _lateness;
+    _lateness = std::chrono::microseconds(0);
+    _deadline = Hardware::clock().now();
+    _started = true;
+}
+
+void StepScheduler::endCycle()
+{
+    ++_cycle;
+
+    if (_reportDrift) {
+        printf("cycle %lu: scheduled %lld ms, lateness %lld us (max %lld us), cumulative drift %lld us\n",
+            (unsigned long)_cycle,
+            (long long)std::chrono::duration_cast<std::chrono::milliseconds>(_cycleScheduled).count(),
+            (long long)_lateness.count(),
+            (long long)_maximumCycleLateness.count(),
+            (long long)getCumulativeDrift().count());
+    }
+
+    _cycleScheduled = std::chrono::microseconds(0);
+    _maximumCycleLateness = std::chrono::microseconds(0);
+}
+
+void StepScheduler::setDriftReporting(bool enabled)
+{
+    _reportDrift = enabled;
+}
+
+std::chrono::microseconds StepScheduler::getLateness()
+{
+    return _lateness;
+}
+
+std::chrono::microseconds StepScheduler::getCumulativeDrift()
+{
+    return _carriedDrift + _lateness;
+}
+
+std::chrono::microseconds StepScheduler::getDeadline()
+{
+    return _deadline;
+}
+
+DurationHistogram &StepScheduler::getLatenessHistogram()
+{
+    return _latenessHistogram;
+}
+
+void StepScheduler::moveDeadline(std::chrono::milliseconds delay)
+{
+    auto now = Hardware::clock().now();
+
+    if (!_started) {
+        _deadline = now;
+        _started = true;
+    }
+    else if (now - _deadline > MaximumCatchUp) {
+        _carriedDrift += now - _deadline;
+        _deadline = now;
+    }
+
+    _deadline += delay;
+    _cycleScheduled += delay;
+
+    Heartbeat::beatBy(_deadline);
+}
+
+void StepScheduler::recordLateness()
+{
+    auto lateness = Hardware::clock().now() - _deadline;
+    _lateness = lateness > std::chrono::microseconds(0) ? lateness : std::chrono::microseconds(0);
+    _latenessHistogram.record(_lateness);
+
+    if (_lateness > _maximumCycleLateness) {
+        _maximumCycleLateness = _lateness;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "duration_histogram.h"
+
+/// @brief Times every step against a running absolute deadline rather than sleeping for each delay in turn, so the time
+/// spent changing lights and setting up sequences is absorbed instead of adding up. The deadline carries on across
+/// steps, sequences and systems until something waits outside of the schedule (such as for a button press), at which
+/// point it should be resynchronised. Lateness is only made up while it is small: once the schedule falls further
+/// behind than MaximumCatchUp it starts again from the current time, so an overrun can't cut the following steps, such
+/// as a yellow or a crossing clearance, short by more than that.
+class StepScheduler
+{
+public:
+    static constexpr std::chrono::milliseconds MaximumCatchUp = std::chrono::milliseconds(10);
+
+    /// @brief Moves the deadline on by delay and sleeps until it is reached.
+    static void waitFor(std::chrono::milliseconds delay);
+
+    /// @brief Moves the deadline on by delay and sleeps until it is reached, waking early if an event is notified after
+    /// watched has changed from value.
+    /// @return False if the wait was cut short, after which the schedule should be resynchronised.
+    static bool waitFor(std::chrono::milliseconds delay, const std::atomic<uint32_t> &watched, uint32_t value);
+
+    /// @brief Starts the schedule again from the current time. Call after any wait that isn't part of the schedule.
+    static void resynchronise();
+
+    /// @brief Marks the end of a cycle of a system. Prints the cycle's drift if drift reporting is enabled.
+    static void endCycle();
+
+    static void setDriftReporting(bool enabled);
+
+    /// @brief Gets how late the last step woke up compared to its deadline.
+    static std::chrono::microseconds getLateness();
+
+    /// @brief Gets how far behind the ideal schedule the lights have slipped in total, including any lateness carried
+    /// over when the schedule was resynchronised.
+    static std::chrono::microseconds getCumulativeDrift();
+
+    static std::chrono::microseconds getDeadline();
+
+    /// @brief Gets how late every step has woken up compared to its deadline, whether stepped here or by a
+    /// CooperativeScheduler.
+    static DurationHistogram &getLatenessHistogram();
+
+private:
+    static bool _started;
+    static bool _reportDrift;
+
+    static uint32_t _cycle;
+
+    static std::chrono::microseconds _deadline;
+    static std::chrono::microseconds _lateness;
+    static std::chrono::microseconds _maximumCycleLateness;
+    static std::chrono::microseconds _carriedDrift;
+    static std::chrono::microseconds _cycleScheduled;
+
+    static DurationHistogram _latenessHistogram;
+
+    static void moveDeadline(std::chrono::milliseconds delay);
+    static void recordLateness();
+};
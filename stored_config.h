@@ -0,0 +1,157 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "config_store.h"
+
+/// @brief The junction set up kept in flash with ConfigStore: the traffic lights, which systems run and any timings
+/// changed from the standard ones. Systems and timings are stored by index, the same way the console addresses them.
+/// Bump Version whenever the layout changes, as records of any other version are ignored, as are records with a pin the
+/// board doesn't have.
+struct StoredConfig
+{
+    static constexpr uint16_t Version = 1;
+    static constexpr size_t MaximumLights = 4;
+    static constexpr size_t MaximumOverrides = 24;
+    static constexpr uint8_t NoPin = 0xff;
+
+    /// @brief The number of GPIO pins on the board. Every pin a light uses must be below it.
+    static constexpr uint8_t PinCount = 30;
+
+    struct Light
+    {
+        uint8_t redPin = NoPin;
+        uint8_t yellowPin = NoPin;
+        uint8_t greenPin = NoPin;
+        uint8_t redCrossingPin = NoPin;
+        uint8_t greenCrossingPin = NoPin;
+        uint8_t commonAnode = 0;
+
+        /// @brief Whether every pin the light uses is on the board. A light with no red pin is a crossing light on its
+        /// own, and one with no red crossing pin has no crossing.
+        constexpr bool isValid() const
+        {
+            if (redPin == NoPin) {
+                return redCrossingPin < PinCount && greenCrossingPin < PinCount;
+            }
+
+            return redPin < PinCount && yellowPin < PinCount && greenPin < PinCount
+                && (redCrossingPin == NoPin || (redCrossingPin < PinCount && greenCrossingPin < PinCount));
+        }
+    };
+
+    struct TimingOverride
+    {
+        uint8_t system = 0;
+        uint8_t timing = 0;
+        int8_t group = -1; //-1 for the whole system.
+        uint8_t reserved = 0;
+        uint32_t milliseconds = 0;
+    };
+
+    uint8_t lightCount = 0;
+    uint8_t overrideCount = 0;
+    uint16_t systems = 0; //One bit for each system to run, or 0 to run them all.
+    Light lights[MaximumLights];
+    TimingOverride overrides[MaximumOverrides];
+
+    bool addLight(const Light &light)
+    {
+        if (lightCount >= MaximumLights) {
+            return false;
+        }
+
+        lights[lightCount++] = light;
+
+        return true;
+    }
+
+    bool addOverride(uint8_t system, size_t timing, int group, std::chrono::milliseconds time)
+    {
+        if (overrideCount >= MaximumOverrides) {
+            return false;
+        }
+
+        auto &entry = overrides[overrideCount++];
+        entry.system = system;
+        entry.timing = (uint8_t)timing;
+        entry.group = (int8_t)group;
+        entry.milliseconds = (uint32_t)time.count();
+
+        return true;
+    }
+
+    /// @brief Removes the override for a timing of a system and group, if there is one.
+    /// @return False if there was none.
+    bool removeOverride(uint8_t system, size_t timing, int group)
+    {
+        for (size_t index = 0; index < overrideCount && index < MaximumOverrides; ++index) {
+            auto &entry = overrides[index];
+
+            if (entry.system == system && entry.timing == timing && entry.group == group) {
+                for (auto next = index + 1; next < overrideCount && next < MaximumOverrides; ++next) {
+                    overrides[next - 1] = overrides[next];
+                }
+
+                --overrideCount;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool runsSystem(uint8_t system) const
+    {
+        return systems == 0 || (systems & (1u << system)) != 0;
+    }
+
+    /// @brief Sets every override for the given system in a timing profile, such as one from
+    /// AbstractSystem::getStandardTimingProfile() or a plan for a TimingPlanSchedule.
+    template<typename Timings>
+    void applyTimings(uint8_t system, Timings &profile) const
+    {
+        for (size_t index = 0; index < overrideCount && index < MaximumOverrides; ++index) {
+            auto &entry = overrides[index];
+
+            if (entry.system == system && entry.timing < Timings::TimingCount) {
+                profile.set(static_cast<typename Timings::Timing>(entry.timing), std::chrono::milliseconds(entry.milliseconds), entry.group);
+            }
+        }
+    }
+
+    /// @brief Whether the counts are in range and every light's pins are on the board, so the config can be trusted to
+    /// build lights from.
+    bool isValid() const
+    {
+        if (lightCount > MaximumLights || overrideCount > MaximumOverrides) {
+            return false;
+        }
+
+        for (size_t index = 0; index < lightCount; ++index) {
+            if (!lights[index].isValid()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// @brief Reads the newest config from the store.
+    /// @return False if there is none, or it isn't valid, in which case whatever was read is left in place and shouldn't be used.
+    bool load(const ConfigStore &store)
+    {
+        return store.read(Version, this, sizeof(*this)) && isValid();
+    }
+
+    bool save(ConfigStore &store) const
+    {
+        return store.write(Version, this, sizeof(*this));
+    }
+};
+
+static_assert(sizeof(StoredConfig) <= ConfigStore::MaximumLength, "StoredConfig must fit in a single ConfigStore slot");
+static_assert(std::is_trivially_copyable<StoredConfig>::value, "StoredConfig is copied to and from flash byte for byte");
\ No newline at end of file
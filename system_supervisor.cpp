@@ -0,0 +1,179 @@
+#include "Hardware/hardware.h"
+#include "step_scheduler.h"
+#include "heartbeat.h"
+
+#include "system_supervisor.h"
+
+int SystemSupervisor::addSystem(std::shared_ptr<RunnableSystem> system)
+{
+    if (!system || _systemCount >= MaximumSystems) {
+        return NoSystem;
+    }
+
+    _systems[_systemCount] = system;
+
+    return (int)_systemCount++;
+}
+
+void SystemSupervisor::requestSwitch(int index, Urgency urgency)
+{
+    if (index < 0 || index >= (int)_systemCount) {
+        return;
+    }
+
+    auto sequence = _nextSequence++;
+    if (_nextSequence == 0) {
+        _nextSequence = 1;
+    }
+
+    // The time is stored first so it is in place by the time the request can be seen.
+    _requestedAt.store((uint32_t)Hardware::clock().now().count(), std::memory_order_relaxed);
+    _request.store((uint32_t)(index + 1) | ((uint32_t)urgency << 16) | ((uint32_t)sequence << 24), std::memory_order_release);
+
+    Hardware::clock().notifyEvent();
+}
+
+int SystemSupervisor::runCycle(int index)
+{
+    if (index < 0 || index >= (int)_systemCount) {
+        return NoSystem;
+    }
+
+    auto &clock = Hardware::clock();
+    auto &system = *_systems[index];
+    auto waitedForRequest = false;
+    auto askedForSafePoint = false;
+    auto shownStep = false;
+    auto cutShort = false;
+    auto startedAt = clock.now();
+
+    _activeSystem.store(index, std::memory_order_relaxed);
+
+    system.start();
+
+    while (true) {
+        auto request = _request.load(std::memory_order_acquire);
+
+        // Nothing has been shown by this system until its first step, so the last system's lights are still up.
+        auto target = NoSystem;
+        if (shownStep && takeSwitch(system, request, askedForSafePoint, target)) {
+            StepScheduler::resynchronise();
+            return target;
+        }
+
+        // A step cut short by a switch that can't be taken yet is shown to its end, unless it only holds a green or a
+        // crossing and the switch is immediate.
+        if (cutShort) {
+            cutShort = false;
+
+            if (isHurrying(request) && system.isHoldingStep()) {
+                waitedForRequest = true;
+            }
+            else if (!StepScheduler::waitFor(std::chrono::milliseconds(0), _request, request)) {
+                cutShort = true;
+                continue;
+            }
+        }
+
+        auto step = system.advance();
+        shownStep = true;
+
+        if (step.type == SystemStep::Type::Finished) {
+            break;
+        }
+
+        if (step.type == SystemStep::Type::AwaitRequest) {
+            Heartbeat::beatIdle();
+            clock.waitForEvent();
+            Heartbeat::beat();
+            waitedForRequest = true;
+            continue;
+        }
+
+        if (waitedForRequest) {
+            StepScheduler::resynchronise();
+            waitedForRequest = false;
+        }
+
+        // A switch waiting on a safe point is taken as soon as one is shown, and holds are skipped on the way to it for
+        // an immediate switch.
+        if (isPending(request) && (system.isAtSafePoint() || (isHurrying(request) && system.isHoldingStep()))) {
+            continue;
+        }
+
+        // Only a request made since the check above cuts the step short, so one waiting on a safe point doesn't.
+        if (!StepScheduler::waitFor(step.delay, _request, request)) {
+            cutShort = true;
+        }
+    }
+
+    system.recordCycle(clock.now() - startedAt);
+    StepScheduler::endCycle();
+
+    // A cycle that finished on red is left for a switch still waiting on a safe point. One that finished anywhere else,
+    // such as between flashes, leaves the switch waiting for the next system to reach one.
+    auto askedAtEnd = true;
+    auto target = NoSystem;
+    if (takeSwitch(system, _request.load(std::memory_order_acquire), askedAtEnd, target)) {
+        return target;
+    }
+
+    return NoSystem;
+}
+
+int SystemSupervisor::getActiveSystem() const
+{
+    return _activeSystem.load(std::memory_order_relaxed);
+}
+
+std::chrono::microseconds SystemSupervisor::getLastSwitchLatency() const
+{
+    return std::chrono::microseconds(_lastSwitchLatency.load(std::memory_order_relaxed));
+}
+
+const DurationHistogram &SystemSupervisor::getSwitchLatencies() const
+{
+    return _switchLatencies;
+}
+
+bool SystemSupervisor::takeSwitch(RunnableSystem &system, uint32_t request, bool &askedForSafePoint, int &target)
+{
+    if (!isPending(request)) {
+        return false;
+    }
+
+    if (!system.isAtSafePoint()) {
+        if (!askedForSafePoint) {
+            system.requestSafePoint();
+            askedForSafePoint = true;
+        }
+
+        return false;
+    }
+
+    _handledSequence = (uint8_t)(request >> 24);
+    askedForSafePoint = false;
+    target = (int)(request & 0xffff) - 1;
+
+    // Asking for the system already running leaves it be.
+    if (target == getActiveSystem()) {
+        return false;
+    }
+
+    // Wraps with the clock every 71 minutes, which the difference survives.
+    auto latency = (uint32_t)Hardware::clock().now().count() - _requestedAt.load(std::memory_order_relaxed);
+    _lastSwitchLatency.store(latency, std::memory_order_relaxed);
+    _switchLatencies.record(std::chrono::microseconds(latency));
+
+    return true;
+}
+
+bool SystemSupervisor::isPending(uint32_t request) const
+{
+    return (uint8_t)(request >> 24) != _handledSequence;
+}
+
+bool SystemSupervisor::isHurrying(uint32_t request) const
+{
+    return isPending(request) && (Urgency)((request >> 16) & 0xff) == Urgency::Immediate;
+}
\ No newline at end of file
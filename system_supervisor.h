@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Systems/runnable_system.h"
+#include "duration_histogram.h"
+
+/// @brief Runs systems one cycle at a time like RunnableSystem::run(), but can be asked from any core to leave the
+/// running system part way through a cycle. Every switch is taken at a safe point, once every light is on red, and asks
+/// the system to head for one rather than wait for a request. A switch is checked for between every step and wakes any
+/// wait, but a step that was cut short carries on to its end unless an immediate switch can skip it, so a yellow or a
+/// clearance is always shown in full. The lights are left on red for the next system to take over from.
+class SystemSupervisor
+{
+public:
+    static constexpr size_t MaximumSystems = 8;
+    static constexpr int NoSystem = -1;
+
+    enum class Urgency : uint8_t
+    {
+        AtSafePoint, //Head for the next safe point at the system's own pace, waiting out greens and crossings.
+        Immediate //Head for the next safe point cutting greens and crossings short, but not the clearances after them.
+    };
+
+    /// @brief Registers a system. Call before any system is run.
+    /// @return The index of the system, or NoSystem if there are already MaximumSystems.
+    int addSystem(std::shared_ptr<RunnableSystem> system);
+
+    /// @brief Asks for the given system to take over from the one running, if any. A later request replaces any that
+    /// hasn't been taken yet. Safe to call from one core or thread other than the one running the systems.
+    void requestSwitch(int index, Urgency urgency = Urgency::AtSafePoint);
+
+    /// @brief Runs a cycle of the system at the given index.
+    /// @return The system to switch to if the cycle was cut short, or NoSystem if it finished.
+    int runCycle(int index);
+
+    /// @brief Gets the system now running, or NoSystem. Safe to call from any core.
+    int getActiveSystem() const;
+
+    /// @brief Gets how long the last switch took from being requested to being taken.
+    std::chrono::microseconds getLastSwitchLatency() const;
+
+    /// @brief Gets how long every switch has taken from being requested to being taken.
+    const DurationHistogram &getSwitchLatencies() const;
+
+private:
+    std::array<std::shared_ptr<RunnableSystem>, MaximumSystems> _systems;
+    size_t _systemCount = 0;
+
+    std::atomic<int> _activeSystem = NoSystem;
+
+    //The system to switch to plus one in the low 16 bits, the urgency above it and a sequence number in the top byte, so
+    //a new request can be told apart from one already handled. Written only by requestSwitch().
+    std::atomic<uint32_t> _request = 0;
+    std::atomic<uint32_t> _requestedAt = 0;
+    uint8_t _nextSequence = 1;
+
+    uint8_t _handledSequence = 0;
+
+    std::atomic<uint32_t> _lastSwitchLatency = 0;
+    DurationHistogram _switchLatencies;
+
+    bool takeSwitch(RunnableSystem &system, uint32_t request, bool &askedForSafePoint, int &target);
+    bool isPending(uint32_t request) const;
+    bool isHurrying(uint32_t request) const;
+};
\ No newline at end of file
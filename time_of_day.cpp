@@ -0,0 +1,46 @@
+#include "Hardware/hardware.h"
+
+#include "time_of_day.h"
+
+static constexpr int64_t SecondsPerDay = 24 * 60 * 60;
+
+std::atomic<int32_t> TimeOfDay::_offset = 0;
+std::atomic<bool> TimeOfDay::_set = false;
+
+static int64_t wrapSeconds(int64_t seconds)
+{
+    seconds %= SecondsPerDay;
+    return seconds < 0 ? seconds + SecondsPerDay : seconds;
+}
+
+void TimeOfDay::set(std::chrono::minutes timeOfDay)
+{
+    auto sinceBoot = std::chrono::duration_cast<std::chrono::seconds>(Hardware::clock().now()).count();
+    auto wanted = std::chrono::duration_cast<std::chrono::seconds>(timeOfDay).count();
+
+    //Released along with the flag so a core that sees it set also sees the offset it was set with.
+    _offset.store((int32_t)wrapSeconds(wanted - sinceBoot), std::memory_order_relaxed);
+    _set.store(true, std::memory_order_release);
+}
+
+void TimeOfDay::clear()
+{
+    _set.store(false, std::memory_order_release);
+}
+
+bool TimeOfDay::isSet()
+{
+    return _set.load(std::memory_order_acquire);
+}
+
+std::chrono::minutes TimeOfDay::get()
+{
+    if (!isSet()) {
+        return std::chrono::minutes(0);
+    }
+
+    auto sinceBoot = std::chrono::duration_cast<std::chrono::seconds>(Hardware::clock().now()).count();
+    auto seconds = wrapSeconds(sinceBoot + _offset.load(std::memory_order_relaxed));
+
+    return std::chrono::duration_cast<std::chrono::minutes>(std::chrono::seconds(seconds));
+}
\ No newline at end of file
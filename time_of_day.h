@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// @brief The time of day for anything that changes with it, such as a TimingPlanSchedule. The board has no clock that
+/// keeps the time, so it is unknown from power on until set, for example from the console. It is kept as an offset from
+/// the time since boot in a single word, so it can be set from one core and read from the other.
+class TimeOfDay
+{
+public:
+    /// @brief Sets the current time of day. Safe to call from any core.
+    static void set(std::chrono::minutes timeOfDay);
+
+    /// @brief Forgets the time of day, as at power on.
+    static void clear();
+
+    static bool isSet();
+
+    /// @brief Gets the current time of day, or midnight if it hasn't been set.
+    static std::chrono::minutes get();
+
+private:
+    //Seconds to add to the time since boot, kept within a day.
+    static std::atomic<int32_t> _offset;
+    static std::atomic<bool> _set;
+};
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "trace_recorder.h"
+#include "trafficlight.h"
+
+static const char *getCauseName(TraceRecord::Cause cause)
+{
+    switch (cause) {
+        case TraceRecord::Cause::SequenceStep:
+            return "sequence step";
+        case TraceRecord::Cause::ShowLights:
+            return "show lights";
+        case TraceRecord::Cause::LightsOn:
+            return "lights on";
+        case TraceRecord::Cause::LightsOff:
+            return "lights off";
+        case TraceRecord::Cause::CrossingRequest:
+            return "crossing request";
+        case TraceRecord::Cause::NextGroupRequest:
+            return "next group request";
+        case TraceRecord::Cause::ModeChange:
+            return "mode change";
+        case TraceRecord::Cause::ConflictFault:
+            return "conflict fault";
+        case TraceRecord::Cause::ModeRejected:
+            return "mode rejected";
+    }
+
+    return "unknown";
+}
+
+static std::string getLightNames(uint8_t lights)
+{
+    static const struct { TrafficLight::Light light; const char *name; } names[] = {
+        { TrafficLight::Light::Red, "red" },
+        { TrafficLight::Light::Yellow, "yellow" },
+        { TrafficLight::Light::Green, "green" },
+        { TrafficLight::Light::RedCrossing, "red crossing" },
+        { TrafficLight::Light::GreenCrossing, "green crossing" }
+    };
+
+    std::string result;
+
+    for (auto &entry : names) {
+        if ((lights & entry.light) != 0) {
+            result += result.empty() ? "" : "+";
+            result += entry.name;
+        }
+    }
+
+    return result.empty() ? "off" : result;
+}
+
+/// @brief Turns a trace dumped by TraceRecorder::dump() into CSV, or a readable timeline with --timeline. Reads the
+/// file given, or stdin, and skips anything outside of the trace so a whole stdio log can be passed in.
+static std::string getDetail(const TraceRecord &record)
+{
+    switch (record.cause) {
+        case TraceRecord::Cause::CrossingRequest:
+        case TraceRecord::Cause::NextGroupRequest:
+            return "-";
+        case TraceRecord::Cause::ModeChange:
+        case TraceRecord::Cause::ModeRejected:
+            return "mode " + std::to_string(record.lights);
+        case TraceRecord::Cause::ConflictFault:
+            return "fault " + std::to_string(record.lights);
+        default:
+            return getLightNames(record.lights);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto timeline = false;
+    FILE *input = stdin;
+
+    for (auto argument = 1; argument < argc; ++argument) {
+        if (strcmp(argv[argument], "--timeline") == 0) {
+            timeline = true;
+        }
+        else if (!(input = fopen(argv[argument], "r"))) {
+            fprintf(stderr, "Couldn't open %s\n", argv[argument]);
+            return 1;
+        }
+    }
+
+    std::vector<TraceRecord> records;
+    long long newestTime = 0;
+    auto inTrace = false;
+    char line[128];
+
+    while (fgets(line, sizeof(line), input)) {
+        unsigned int count = 0;
+
+        if (sscanf(line, "trace begin %u %lld", &count, &newestTime) == 2) {
+            records.clear();
+            inTrace = true;
+            continue;
+        }
+
+        if (strncmp(line, "trace end", 9) == 0) {
+            inTrace = false;
+            continue;
+        }
+
+        unsigned long delta;
+        unsigned int groupId, lights, cause;
+
+        if (inTrace && sscanf(line, "%8lx%2x%2x%2x", &delta, &groupId, &lights, &cause) == 4) {
+            TraceRecord record;
+            record.timeDelta = delta;
+            record.groupId = groupId;
+            record.lights = lights;
+            record.cause = (TraceRecord::Cause)cause;
+
+            records.push_back(record);
+        }
+    }
+
+    //Only the newest time is known, so work back through the gaps to find the others.
+    std::vector<long long> times(records.size());
+    auto time = newestTime;
+
+    for (size_t index = records.size(); index > 0; --index) {
+        times[index - 1] = time;
+        time -= records[index - 1].timeDelta;
+    }
+
+    if (!timeline) {
+        printf("time_us,group,lights,cause\n");
+    }
+
+    for (size_t index = 0; index < records.size(); ++index) {
+        auto &record = records[index];
+        auto group = record.groupId == TraceRecord::NoGroup ? std::string("-") : std::to_string(record.groupId);
+
+        if (timeline) {
+            printf("%10.3f s  group %-3s %-28s %s\n", times[index] / 1000000.0, group.c_str(), getDetail(record).c_str(), getCauseName(record.cause));
+        }
+        else {
+            printf("%lld,%s,%s,%s\n", times[index], group.c_str(), getDetail(record).c_str(), getCauseName(record.cause));
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <cstdio>
+
+#include "Hardware/hardware.h"
+
+#include "trace_recorder.h"
+
+std::atomic<uint32_t> TraceRecorder::_sequence = 0;
+bool TraceRecorder::_enabled = true;
+size_t TraceRecorder::_next = 0;
+size_t TraceRecorder::_count = 0;
+std::chrono::microseconds TraceRecorder::_lastTime = std::chrono::microseconds(0);
+std::array<TraceRecord, TraceRecorder::Capacity> TraceRecorder::_records;
+
+void TraceRecorder::record(uint8_t groupId, uint8_t lights, TraceRecord::Cause cause)
+{
+    if (!_enabled) {
+        return;
+    }
+
+    auto now = Hardware::clock().now();
+    auto delta = _count > 0 ? (now - _lastTime).count() : 0;
+
+    auto sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    _lastTime = now;
+
+    auto &record = _records[_next];
+    record.timeDelta = delta < 0 ? 0 : (delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta);
+    record.groupId = groupId;
+    record.lights = lights;
+    record.cause = cause;
+
+    _next = (_next + 1) % Capacity;
+
+    if (_count < Capacity) {
+        ++_count;
+    }
+
+    _sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+void TraceRecorder::clear()
+{
+    auto sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    _next = 0;
+    _count = 0;
+
+    _sequence.store(sequence + 2, std::memory_order_release);
+}
+
+size_t TraceRecorder::count()
+{
+    return _count;
+}
+
+TraceRecord TraceRecorder::get(size_t index)
+{
+    if (index >= _count) {
+        return TraceRecord();
+    }
+
+    return _records[(_next + Capacity - _count + index) % Capacity];
+}
+
+void TraceRecorder::dump()
+{
+    printf(BeginFormat, (unsigned int)_count, (long long)_lastTime.count());
+
+    for (size_t index = 0; index < _count; ++index) {
+        auto record = get(index);
+        printf(RecordFormat, (unsigned long)record.timeDelta, record.groupId, record.lights, (unsigned int)record.cause);
+    }
+
+    printf(EndLine);
+}
+
+bool TraceRecorder::snapshot(Snapshot &snapshot)
+{
+    for (auto attempt = 0; attempt < MaximumSnapshotAttempts; ++attempt) {
+        auto before = _sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            continue;
+        }
+
+        snapshot.count = _count;
+        snapshot.lastTime = _lastTime;
+
+        auto next = _next;
+        for (size_t index = 0; index < snapshot.count && index < Capacity; ++index) {
+            snapshot.records[index] = _records[(next + Capacity - snapshot.count + index) % Capacity];
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief A single 8 byte trace entry. The time is stored as the gap since the entry before it.
+struct TraceRecord
+{
+    enum class Cause : uint8_t
+    {
+        SequenceStep, //A controller showed the next step of a sequence.
+        ShowLights, //A group was told to show lights directly.
+        LightsOn, //Lights were turned on without touching the others.
+        LightsOff, //Lights were turned off without touching the others.
+        CrossingRequest, //A system took a request to cross.
+        NextGroupRequest, //A system took a request to manually advance to the next group.
+        ModeChange, //A system took a request to change its mode. The new mode is kept in place of the lights.
+        ConflictFault, //The conflict monitor stopped the lights. The ConflictFault is kept in place of the lights.
+        ModeRejected //A system dropped a request for a mode it doesn't have. The mode, up to 255, is kept in place of the lights.
+    };
+
+    static constexpr uint8_t NoGroup = 0xff;
+
+    uint32_t timeDelta = 0; //Microseconds since the previous record, saturating.
+    uint8_t groupId = NoGroup;
+    uint8_t lights = 0;
+    Cause cause = Cause::SequenceStep;
+    uint8_t reserved = 0;
+};
+
+/// @brief Keeps the most recent light changes and requests in a fixed ring in RAM so what a junction did can be dumped
+/// after the fact. Recording is a handful of stores with no allocation, and once the ring is full the oldest records
+/// are overwritten. Records must only be made from the core running the systems, but another core can take a snapshot
+/// of the ring at any time: each record is bracketed by a sequence number, and a snapshot that overlapped one is taken
+/// again.
+class TraceRecorder
+{
+public:
+    static constexpr size_t Capacity = 256;
+
+    /// @brief A copy of the ring, oldest record first, along with the time of the newest record in microseconds.
+    struct Snapshot
+    {
+        size_t count = 0;
+        std::chrono::microseconds lastTime = std::chrono::microseconds(0);
+        std::array<TraceRecord, Capacity> records;
+    };
+
+    /// @brief The lines dump() prints, for printing a snapshot some other way, such as through the console.
+    static constexpr const char *BeginFormat = "trace begin %u %lld\n";
+    static constexpr const char *RecordFormat = "%08lx%02x%02x%02x\n";
+    static constexpr const char *EndLine = "trace end\n";
+
+    static void record(uint8_t groupId, uint8_t lights, TraceRecord::Cause cause);
+
+    static void setEnabled(bool enabled);
+    static void clear();
+
+    static size_t count();
+
+    /// @brief Gets a record, oldest first.
+    static TraceRecord get(size_t index);
+
+    /// @brief Prints every record over stdio as hex between "trace begin" and "trace end" lines, oldest first. The begin
+    /// line holds the number of records and the time of the newest in microseconds, so the decoder can work out the
+    /// time of each record even once the oldest have been overwritten.
+    static void dump();
+
+    /// @brief Copies the ring without stopping the core making records. Safe to call from any core.
+    /// @return False if records kept being made while copying, however many times it was tried.
+    static bool snapshot(Snapshot &snapshot);
+
+private:
+    static constexpr int MaximumSnapshotAttempts = 4;
+
+    //Odd while a record is being made.
+    static std::atomic<uint32_t> _sequence;
+
+    static bool _enabled;
+    static size_t _next;
+    static size_t _count;
+    static std::chrono::microseconds _lastTime;
+    static std::array<TraceRecord, Capacity> _records;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <stdexcept>
 
-#include "pico/stdlib.h"
+#include "Hardware/hardware.h"
+#include "conflict_monitor.h"
 
 #include "trafficlight.h"
 
@@ -62,17 +63,30 @@ void TrafficLight::turnLightsOff(Light lights)
 
 void TrafficLight::setLightsState(Light lights, bool on)
 {    
-    for (auto pinMapping : _lightPinMap) {
-        if ((lights & pinMapping.first) != 0 && hasValidPin(pinMapping.first)) {
-            gpio_put(pinMapping.second, shouldInvertOnOff() ? !on : on);
-        }
+    auto mask = getPinMask(lights);
+    if (mask != 0) {
+        ConflictMonitor::commit(nullptr, mask, (on ? mask : 0) ^ getInvertMask());
+    }
+}
+
+void TrafficLight::showLights(Light lights)
+{
+    if (_bankMask != 0) {
+        ConflictMonitor::commit(nullptr, _bankMask, getPinMask(lights) ^ getInvertMask());
     }
 }
 
 void TrafficLight::setPin(Light light, uint pin)
 {
     _lightPinMap[light] = pin;
-    
+
+    for (size_t index = 0; index < LightCount; ++index) {
+        if ((light & (1 << index)) != 0) {
+            _pinMasks[index] = 1u << pin;
+        }
+    }
+
+    updateBankMask();
     initPin(pin);
 }
 
@@ -101,10 +115,36 @@ uint TrafficLight::getPin(Light light) const
     return 0;
 }
 
+uint32_t TrafficLight::getPinMask(Light lights) const
+{
+    uint32_t mask = 0;
+
+    for (size_t index = 0; index < LightCount; ++index) {
+        if ((lights & (1 << index)) != 0) {
+            mask |= _pinMasks[index];
+        }
+    }
+
+    return mask;
+}
+
+uint32_t TrafficLight::getInvertMask() const
+{
+    return shouldInvertOnOff() ? _bankMask : 0;
+}
+
 void TrafficLight::initPin(uint pin)
 {
-    gpio_init(pin);
-    gpio_set_dir(pin, GPIO_OUT);
+    Hardware::gpio().initOutputPin(pin);
+}
+
+void TrafficLight::updateBankMask()
+{
+    _bankMask = 0;
+
+    for (auto pinMask : _pinMasks) {
+        _bankMask |= pinMask;
+    }
 }
 
 bool TrafficLight::shouldInvertOnOff() const
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <map>
+#include <cstddef>
 
-#include "pico/stdlib.h"
+#include "Hardware/hardware_types.h"
 
 class TrafficLight
 {
@@ -29,6 +30,8 @@ public:
         All = Main | Crossing
     };
 
+    static constexpr size_t LightCount = 5;
+
     TrafficLight(uint redPin, uint yellowPin, uint greenPin, LedType ledType = LedType::CommonCathode);
     TrafficLight(uint redPin, uint yellowPin, uint greenPin, uint redCrossingPin, uint greenCrossingPin, LedType ledType = LedType::CommonCathode);
     TrafficLight(uint redCrossingPin, uint greenCrossingPin, LedType ledType = LedType::CommonCathode);
@@ -40,6 +43,10 @@ public:
     void turnLightsOn(Light lights);
     void turnLightsOff(Light lights);
     void setLightsState(Light lights, bool on);
+
+    /// @brief Turns on exactly the given lights and turns every other light off with a single write, so lights that
+    /// stay on don't flicker.
+    void showLights(Light lights);
     void setPin(Light light, uint pin);
 
     bool hasLights() const;
@@ -48,15 +55,25 @@ public:
 
     uint getPin(Light light) const;
 
+    /// @brief Gets the mask of every pin used by the given lights.
+    uint32_t getPinMask(Light lights) const;
+
+    /// @brief Gets the mask of pins that need to be driven low to turn a light on.
+    uint32_t getInvertMask() const;
+
 private:
     bool _hasLights = false;
     bool _hasCrossingLights = false;
 
     LedType _ledType = LedType::CommonCathode;
     
+    uint32_t _pinMasks[LightCount] = {};
+    uint32_t _bankMask = 0;
+
     std::map<Light, uint> _lightPinMap;
 
     void initPin(uint pin);
+    void updateBankMask();
 
     bool shouldInvertOnOff() const;
 };
\ No newline at end of file
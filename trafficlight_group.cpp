@@ -1,10 +1,16 @@
+#include "Hardware/hardware.h"
+#include "trace_recorder.h"
+#include "conflict_monitor.h"
+
 #include "trafficlight_group.h"
 
-TrafficLightGroup::TrafficLightGroup()
+uint8_t TrafficLightGroup::_nextTraceId = 0;
+
+TrafficLightGroup::TrafficLightGroup() : _traceId(_nextTraceId++)
 {
 }
 
-TrafficLightGroup::TrafficLightGroup(std::vector<std::shared_ptr<TrafficLight>> trafficLights)
+TrafficLightGroup::TrafficLightGroup(std::vector<std::shared_ptr<TrafficLight>> trafficLights) : TrafficLightGroup()
 {
     for (auto trafficLight : trafficLights) {
         addTrafficLight(trafficLight);
@@ -14,37 +20,83 @@ TrafficLightGroup::TrafficLightGroup(std::vector<std::shared_ptr<TrafficLight>>
 void TrafficLightGroup::addTrafficLight(std::shared_ptr<TrafficLight> trafficLight)
 {
     _trafficLights.push_back(trafficLight);
+
+    for (size_t index = 0; index < TrafficLight::LightCount; ++index) {
+        _pinMasks[index] |= trafficLight->getPinMask((TrafficLight::Light)(1 << index));
+    }
+
+    _bankMask |= trafficLight->getPinMask(TrafficLight::Light::All);
+    _invertMask |= trafficLight->getInvertMask();
+
+    ++_revision;
 }
 
 void TrafficLightGroup::turnAllLightsOff()
 {
-    for (auto trafficLight : _trafficLights) {
-        trafficLight->turnAllLightsOff();
-    }
+    turnLightsOff(TrafficLight::Light::All);
 }
 
 void TrafficLightGroup::turnLightsOn(TrafficLight::Light lights)
 {
-    for (auto trafficLight : _trafficLights) {
-        trafficLight->turnLightsOn(lights);
-    }
+    setLightsState(lights, true);
 }
 
 void TrafficLightGroup::turnLightsOff(TrafficLight::Light lights)
 {
-    for (auto trafficLight : _trafficLights) {
-        trafficLight->turnLightsOff(lights);
-    }
+    setLightsState(lights, false);
 }
 
 void TrafficLightGroup::setLightsState(TrafficLight::Light lights, bool on)
 {
-    for (auto trafficLight : _trafficLights) {
-        trafficLight->setLightsState(lights, on);
+    auto mask = getPinMask(lights);
+    if (mask != 0) {
+        ConflictMonitor::commit(nullptr, mask, (on ? mask : 0) ^ _invertMask);
+        TraceRecorder::record(_traceId, lights, on ? TraceRecord::Cause::LightsOn : TraceRecord::Cause::LightsOff);
+    }
+}
+
+void TrafficLightGroup::showLights(TrafficLight::Light lights)
+{
+    if (_bankMask != 0) {
+        ConflictMonitor::commit(nullptr, _bankMask, getPinMask(lights) ^ _invertMask);
+        TraceRecorder::record(_traceId, lights, TraceRecord::Cause::ShowLights);
     }
 }
 
 std::vector<std::shared_ptr<TrafficLight>> TrafficLightGroup::getTrafficLights() const
 {
     return _trafficLights;
+}
+
+uint32_t TrafficLightGroup::getPinMask(TrafficLight::Light lights) const
+{
+    uint32_t mask = 0;
+
+    for (size_t index = 0; index < TrafficLight::LightCount; ++index) {
+        if ((lights & (1 << index)) != 0) {
+            mask |= _pinMasks[index];
+        }
+    }
+
+    return mask;
+}
+
+uint32_t TrafficLightGroup::getInvertMask() const
+{
+    return _invertMask;
+}
+
+uint32_t TrafficLightGroup::getBankMask() const
+{
+    return _bankMask;
+}
+
+uint8_t TrafficLightGroup::getTraceId() const
+{
+    return _traceId;
+}
+
+uint32_t TrafficLightGroup::getRevision() const
+{
+    return _revision;
 }
\ No newline at end of file
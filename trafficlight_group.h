@@ -17,8 +17,33 @@ public:
     void turnLightsOff(TrafficLight::Light lights);
     void setLightsState(TrafficLight::Light lights, bool on);
 
+    /// @brief Turns on exactly the given lights on every traffic light in the group and turns every other light off
+    /// with a single write. The pin masks are worked out when traffic lights are added, so lights should have their
+    /// pins set up before being added to a group.
+    void showLights(TrafficLight::Light lights);
+
     std::vector<std::shared_ptr<TrafficLight>> getTrafficLights() const;
 
+    uint32_t getPinMask(TrafficLight::Light lights) const;
+    uint32_t getInvertMask() const;
+
+    /// @brief Gets every pin used by the group.
+    uint32_t getBankMask() const;
+
+    /// @brief Gets the id the group's light changes are traced under. Every group is given its own when it is created.
+    uint8_t getTraceId() const;
+
+    /// @brief Counts every traffic light added, so anything built from the group's masks can tell when it is out of date.
+    uint32_t getRevision() const;
+
 private:
+    uint32_t _pinMasks[TrafficLight::LightCount] = {};
+    uint32_t _bankMask = 0;
+    uint32_t _invertMask = 0;
+    uint32_t _revision = 0;
+    uint8_t _traceId = 0;
+
+    static uint8_t _nextTraceId;
+
     std::vector<std::shared_ptr<TrafficLight>> _trafficLights;
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/// @brief Lock-free hand over of a value from one writer to one reader, without tearing. The writer fills a spare
+/// buffer and publishes it; the reader switches to the latest published buffer when it chooses to and reads it in place
+/// until it switches again. Two buffers aren't enough to let the writer carry on without waiting for the reader, so a
+/// third is kept spare. Like SpscQueue it only uses atomic loads and stores, so it is safe between the two RP2040 cores.
+template<typename T>
+class TripleBuffer
+{
+public:
+    /// @brief Sets every buffer to the given value. Only call this before the writer and reader start.
+    void reset(const T &value)
+    {
+        for (auto &buffer : _buffers) {
+            buffer = value;
+        }
+
+        _front = 0;
+        _latest.store(0);
+        _reading.store(0);
+    }
+
+    /// @brief Writer side. Copies the value into a buffer the reader isn't using and makes it the latest.
+    void publish(const T &value)
+    {
+        auto latest = _latest.load(std::memory_order_relaxed);
+        auto reading = _reading.load();
+
+        uint8_t spare = 0;
+        while (spare == latest || spare == reading) {
+            ++spare;
+        }
+
+        _buffers[spare] = value;
+        _latest.store(spare);
+    }
+
+    /// @brief Reader side. Switches to the latest published value.
+    /// @return True if a newer value was picked up.
+    bool update()
+    {
+        auto latest = _latest.load();
+        if (latest == _front) {
+            return false;
+        }
+
+        //Claim the buffer, then make sure the writer hadn't already moved on before it could see the claim.
+        while (true) {
+            _reading.store(latest);
+
+            auto confirmed = _latest.load();
+            if (confirmed == latest) {
+                break;
+            }
+
+            latest = confirmed;
+        }
+
+        _front = latest;
+
+        return true;
+    }
+
+    /// @brief Reader side. The value currently in use, which can be changed in place until the next update.
+    T &read()
+    {
+        return _buffers[_front];
+    }
+
+    const T &read() const
+    {
+        return _buffers[_front];
+    }
+
+private:
+    std::array<T, 3> _buffers;
+    uint8_t _front = 0;
+    std::atomic<uint8_t> _latest { 0 };
+    std::atomic<uint8_t> _reading { 0 };
+};
\ No newline at end of file